@@ -22,6 +22,9 @@ namespace opdet {
     void doReconfigure(fhicl::ParameterSet const& p) override;
     bool doDetected(int OpChannel, const sim::OnePhoton& Phot, int& newOpChannel) const override;
     bool doDetectedLite(int OpChannel, int& newOpChannel) const override;
+    void doDetectedLitePhotons(int OpChannel,
+                               int nPhotons,
+                               std::vector<std::pair<int, int>>& nDetectedPerChannel) const override;
 
   }; // class DefaultOpDetResponse
 
@@ -69,6 +72,15 @@ namespace opdet {
     return true;
   }
 
+  //--------------------------------------------------------------------
+  void DefaultOpDetResponse::doDetectedLitePhotons(
+    int OpChannel,
+    int nPhotons,
+    std::vector<std::pair<int, int>>& nDetectedPerChannel) const
+  {
+    if (nPhotons > 0) nDetectedPerChannel.emplace_back(OpChannel, nPhotons);
+  }
+
 } // namespace
 
 DEFINE_ART_SERVICE_INTERFACE_IMPL(opdet::DefaultOpDetResponse, opdet::OpDetResponseInterface)
@@ -47,6 +47,8 @@ struct opdet::IPedAlgoMakerTool {
    *
    * The returned object is completely independent of this tool: after calling
    * this function, the tool can in principle be discarded.
+   * Each call returns a new instance sharing no state with the previous ones,
+   * which is the way to obtain one algorithm per thread.
    *
    * Note that all the information necessary to the creation of the algorithm
    * must have already been passed to the tool (and stored) in the FHiCL
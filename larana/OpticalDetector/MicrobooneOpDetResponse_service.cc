@@ -19,6 +19,9 @@ namespace opdet {
     void doReconfigure(fhicl::ParameterSet const& p) override;
     bool doDetected(int OpChannel, const sim::OnePhoton& Phot, int& newOpChannel) const override;
     bool doDetectedLite(int OpChannel, int& newOpChannel) const override;
+    void doDetectedLitePhotons(int OpChannel,
+                               int nPhotons,
+                               std::vector<std::pair<int, int>>& nDetectedPerChannel) const override;
 
     float fQE; // Quantum efficiency of tube
 
@@ -104,6 +107,16 @@ namespace opdet {
     return true;
   }
 
+  //--------------------------------------------------------------------
+  void MicrobooneOpDetResponse::doDetectedLitePhotons(
+    int OpChannel,
+    int nPhotons,
+    std::vector<std::pair<int, int>>& nDetectedPerChannel) const
+  {
+    // No QE here either: it is applied in the uboone electronics simulation
+    if (nPhotons > 0) nDetectedPerChannel.emplace_back(OpChannel, nPhotons);
+  }
+
 } // namespace
 
 DEFINE_ART_SERVICE_INTERFACE_IMPL(opdet::MicrobooneOpDetResponse, opdet::OpDetResponseInterface)
@@ -23,6 +23,9 @@ namespace fhicl {
   class ParameterSet;
 }
 
+#include <utility>
+#include <vector>
+
 namespace opdet {
   class OpDetResponseInterface {
   public:
@@ -40,6 +43,12 @@ namespace opdet {
     virtual bool detected(int OpChannel, const sim::OnePhoton& Phot) const;
     virtual bool detectedLite(int OpChannel, int& newOpChannel) const;
     virtual bool detectedLite(int OpChannel) const;
+    // Detection of nPhotons photons arriving together on OpChannel:
+    // nDetectedPerChannel is filled with (readout channel, number detected)
+    // pairs, leaving out the channels where none was detected
+    virtual void detectedLite(int OpChannel,
+                              int nPhotons,
+                              std::vector<std::pair<int, int>>& nDetectedPerChannel) const;
 
     virtual float wavelength(double energy) const;
 
@@ -51,6 +60,11 @@ namespace opdet {
 
     virtual bool doDetected(int OpChannel, const sim::OnePhoton& Phot, int& newOpChannel) const = 0;
     virtual bool doDetectedLite(int OpChannel, int& newOpChannel) const = 0;
+    // By default each photon is tried in turn; responses with a quantum
+    // efficiency can answer with a single binomial draw instead
+    virtual void doDetectedLitePhotons(int OpChannel,
+                                       int nPhotons,
+                                       std::vector<std::pair<int, int>>& nDetectedPerChannel) const;
 
   }; // class OpDetResponse
 
@@ -113,6 +127,32 @@ namespace opdet {
     return doDetectedLite(OpChannel, newOpChannel);
   }
 
+  //-------------------------------------------------------------------------------------------------------------
+  inline void OpDetResponseInterface::detectedLite(
+    int OpChannel,
+    int nPhotons,
+    std::vector<std::pair<int, int>>& nDetectedPerChannel) const
+  {
+    nDetectedPerChannel.clear();
+    doDetectedLitePhotons(OpChannel, nPhotons, nDetectedPerChannel);
+  }
+
+  //-------------------------------------------------------------------------------------------------------------
+  inline void OpDetResponseInterface::doDetectedLitePhotons(
+    int OpChannel,
+    int nPhotons,
+    std::vector<std::pair<int, int>>& nDetectedPerChannel) const
+  {
+    // Each photon may be read out by a different channel
+    int newOpChannel;
+    for (int i = 0; i < nPhotons; ++i) {
+      if (!doDetectedLite(OpChannel, newOpChannel)) continue;
+      if (nDetectedPerChannel.empty() || nDetectedPerChannel.back().first != newOpChannel)
+        nDetectedPerChannel.emplace_back(newOpChannel, 0);
+      ++nDetectedPerChannel.back().second;
+    }
+  }
+
   //-------------------------------------------------------------------------------------------------------------
   inline float OpDetResponseInterface::wavelength(double energy) const
   {
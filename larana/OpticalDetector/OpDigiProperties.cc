@@ -143,7 +143,21 @@ namespace opdet {
     return CLHEP::RandGauss::shoot(fHighGainArray[ch], fGainSpreadArray[ch] * fHighGainArray[ch]);
   }
   //--------------------------------------------------------------------
-  optdata::TimeSlice_t OpDigiProperties::GetTimeSlice(double time_ns)
+  // (RandGauss::shoot keeps its spare value per thread, not per engine: a
+  // local distribution keeps the draws a function of the engine state only)
+  double OpDigiProperties::LowGain(optdata::Channel_t ch, CLHEP::HepRandomEngine& engine) const
+  {
+    return CLHEP::RandGauss(engine).fire(fLowGainArray[ch],
+                                         fGainSpreadArray[ch] * fLowGainArray[ch]);
+  }
+  //--------------------------------------------------------------------
+  double OpDigiProperties::HighGain(optdata::Channel_t ch, CLHEP::HepRandomEngine& engine) const
+  {
+    return CLHEP::RandGauss(engine).fire(fHighGainArray[ch],
+                                         fGainSpreadArray[ch] * fHighGainArray[ch]);
+  }
+  //--------------------------------------------------------------------
+  optdata::TimeSlice_t OpDigiProperties::GetTimeSlice(double time_ns) const
   {
     if (time_ns / 1.e3 > (fTimeEnd - fTimeBegin))
       return std::numeric_limits<optdata::TimeSlice_t>::max();
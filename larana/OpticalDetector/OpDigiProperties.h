@@ -24,6 +24,11 @@ namespace fhicl {
 // ROOT includes
 class TF1;
 
+// CLHEP includes
+namespace CLHEP {
+  class HepRandomEngine;
+}
+
 #include <string>
 #include <vector>
 
@@ -49,7 +54,7 @@ namespace opdet {
 	  Convert the given time into time-slice number.
 	  Input time should be in ns unit and measurd w.r.t. MC photon T0
       */
-    optdata::TimeSlice_t GetTimeSlice(double time_ns);
+    optdata::TimeSlice_t GetTimeSlice(double time_ns) const;
 
     /// Returns quantum efficiency
     double QE() const noexcept { return fQE; }
@@ -84,6 +89,10 @@ namespace opdet {
     double LowGain(optdata::Channel_t ch) const;
     /// Generate & return HIGH gain value for an input channel using mean & spread for this channel
     double HighGain(optdata::Channel_t ch) const;
+    /// Same as LowGain(ch), drawing from the given random engine
+    double LowGain(optdata::Channel_t ch, CLHEP::HepRandomEngine& engine) const;
+    /// Same as HighGain(ch), drawing from the given random engine
+    double HighGain(optdata::Channel_t ch, CLHEP::HepRandomEngine& engine) const;
 
     /// Returns a vector of double which represents a binned SPE waveform
     std::vector<double> const& SinglePEWaveform() const noexcept { return fWaveform; }
@@ -11,10 +11,13 @@
  */
 
 #include "OpFlashAlg.h"
+#include "PermutationUtils.h"
 
 #include "TFile.h"
 #include "TH1.h"
 
+#include "cetlib_except/exception.h"
+
 #include "larcorealg/Geometry/GeometryCore.h"
 #include "larcorealg/Geometry/OpDetGeo.h"
 #include "larcoreobj/SimpleTypesAndConstants/geo_types.h"
@@ -23,13 +26,84 @@
 #include "lardataobj/RecoBase/OpFlash.h"
 #include "lardataobj/RecoBase/OpHit.h"
 
+#include "tbb/blocked_range.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/parallel_for.h"
+
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <iterator> // std::back_inserter()
 #include <numeric> // std::iota()
+#include <utility> // std::pair
 
 namespace opdet {
 
+  namespace {
+    // Argon time const is 1600 ns, so 1.6.
+    constexpr double LateLightTimeConstant = 1.6;
+
+    // Flashes within this many sigma of the late light of an earlier flash are removed
+    constexpr double LateLightNSigma = 3.0;
+
+    // Buffers for the construction of one flash at a time, one set per thread
+    struct FlashScratch {
+      std::vector<double> sumw;
+      std::vector<double> sumw2;
+    };
+
+    void SortHitsByTime(std::vector<recob::OpHit> const& HitVector, std::vector<int>& HitsByTime);
+
+    void BinHits(std::vector<recob::OpHit> const& HitVector,
+                 double MinTime,
+                 double BinWidth,
+                 double BinOffset,
+                 unsigned int NBins,
+                 float FlashThreshold,
+                 FlashAccumulator& Accumulator,
+                 OpFlashWorkspace& Workspace);
+
+    void SweepAccumulator(std::vector<int> const& HitsByTime,
+                          std::vector<recob::OpHit> const& HitVector,
+                          double MinTime,
+                          double BinWidth,
+                          double BinOffset,
+                          float FlashThreshold,
+                          FlashAccumulator& Accumulator,
+                          OpFlashWorkspace& Workspace);
+
+    void RefineHits(int const* FirstHit,
+                    int const* LastHit,
+                    std::vector<recob::OpHit> const& HitVector,
+                    float WidthTolerance,
+                    float FlashThreshold,
+                    OpFlashWorkspace& Workspace);
+
+    template <typename Geometry>
+    recob::OpFlash MakeFlash(int const* FirstHit,
+                             int const* LastHit,
+                             std::vector<recob::OpHit> const& HitVector,
+                             Geometry const& geom,
+                             unsigned int NChannels,
+                             unsigned int Nplanes,
+                             detinfo::DetectorClocksData const& ClocksData,
+                             float TrigCoinc,
+                             FlashScratch& scratch);
+
+    void ToLists(std::vector<std::vector<int>> const& Vectors, HitIndexLists& Lists)
+    {
+      Lists.Clear();
+      for (auto const& Vector : Vectors)
+        Lists.Add(Vector.begin(), Vector.end());
+    }
+
+    void AppendVectors(HitIndexLists const& Lists, std::vector<std::vector<int>>& Vectors)
+    {
+      for (size_t i = 0; i != Lists.NLists(); ++i)
+        Vectors.emplace_back(Lists.Begin(i), Lists.End(i));
+    }
+  }
+
   //----------------------------------------------------------------------------
   void writeHistogram(std::vector<double> const& binned)
   {
@@ -56,6 +130,78 @@ namespace opdet {
         std::cout << "OnBeamFlash with time " << flash.Time() << std::endl;
   }
 
+  //----------------------------------------------------------------------------
+  OpChannelGeometry::OpChannelGeometry(geo::GeometryCore const& geom)
+    : fNplanes(geom.Nplanes())
+    , fStatus(geom.MaxOpChannel() + 1, kNoChannel)
+    , fY(geom.MaxOpChannel() + 1, 0.0)
+    , fZ(geom.MaxOpChannel() + 1, 0.0)
+    , fWires((geom.MaxOpChannel() + 1) * fNplanes, 0.0)
+  {
+    for (unsigned int channel = 0; channel != fStatus.size(); ++channel) {
+
+      if (!geom.IsValidOpChannel(channel)) continue;
+
+      auto const xyz = geom.OpDetGeoFromOpChannel(channel).GetCenter();
+      fY[channel] = xyz.Y();
+      fZ[channel] = xyz.Z();
+      fStatus[channel] = kNoTPC;
+
+      geo::TPCID tpc = geom.FindTPCAtPosition(xyz);
+      // if the point does not fall into any TPC,
+      // it does not contribute to the average wire position
+      if (!tpc.isValid) continue;
+
+      // the lookup can fail for a detector inside the TPC volume; such a
+      // channel only becomes an error if one of its hits is used
+      try {
+        for (size_t p = 0; p != fNplanes; ++p) {
+          geo::PlaneID const planeID(tpc, p);
+          fWires[channel * fNplanes + p] = geom.NearestWireID(xyz, planeID).Wire;
+        }
+      }
+      catch (cet::exception const&) {
+        fStatus[channel] = kNoWire;
+        continue;
+      }
+      fStatus[channel] = kInTPC;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  OpChannelGeometry::OpChannelGeometry(unsigned int const Nplanes,
+                                       std::vector<double> Y,
+                                       std::vector<double> Z)
+    : fNplanes(Nplanes)
+    , fStatus(Y.size(), kNoTPC)
+    , fY(std::move(Y))
+    , fZ(std::move(Z))
+    , fWires(fY.size() * fNplanes, 0.0)
+  {
+    if (fZ.size() != fY.size())
+      throw cet::exception("OpFlashAlg") << "OpChannelGeometry: " << fY.size() << " y but "
+                                         << fZ.size() << " z positions\n";
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int OpChannelGeometry::CheckedChannel(unsigned int const channel) const
+  {
+    if (channel >= fStatus.size() || fStatus[channel] == kNoChannel)
+      throw cet::exception("OpFlashAlg") << "No geometry for optical channel " << channel << "\n";
+    return channel;
+  }
+
+  //----------------------------------------------------------------------------
+  double const* OpChannelGeometry::Wires(unsigned int const channel) const
+  {
+    auto const status = fStatus[CheckedChannel(channel)];
+    if (status == kNoWire)
+      throw cet::exception("OpFlashAlg")
+        << "No nearest wire found for optical channel " << channel << "\n";
+    if (status != kInTPC) return nullptr;
+    return &fWires[channel * fNplanes];
+  }
+
   //----------------------------------------------------------------------------
   void RunFlashFinder(std::vector<recob::OpHit> const& HitVector,
                       std::vector<recob::OpFlash>& FlashVector,
@@ -65,105 +211,238 @@ namespace opdet {
                       float const FlashThreshold,
                       float const WidthTolerance,
                       detinfo::DetectorClocksData const& ClocksData,
-                      float const TrigCoinc)
+                      float const TrigCoinc,
+                      bool const SweepSeeding)
   {
-    // Initial size for accumulators - will be automatically extended if needed
-    int initialsize = 6400;
-
-    // These are the accumulators which will hold broad-binned light yields
-    std::vector<double> Binned1(initialsize);
-    std::vector<double> Binned2(initialsize);
-
-    // These will keep track of which pulses put activity in each bin
-    std::vector<std::vector<int>> Contributors1(initialsize);
-    std::vector<std::vector<int>> Contributors2(initialsize);
-
-    // These will keep track of where we have met the flash condition
-    // (in order to prevent second pointless loop)
-    std::vector<int> FlashesInAccumulator1;
-    std::vector<int> FlashesInAccumulator2;
-
-    double minTime = std::numeric_limits<float>::max();
-    for (auto const& hit : HitVector)
-      if (hit.PeakTime() < minTime) minTime = hit.PeakTime();
-
-    for (auto const& hit : HitVector) {
-
-      double peakTime = hit.PeakTime();
-
-      unsigned int AccumIndex1 = GetAccumIndex(peakTime, minTime, BinWidth, 0.0);
+    RunFlashFinder(HitVector,
+                   FlashVector,
+                   AssocList,
+                   BinWidth,
+                   OpChannelGeometry(geom),
+                   FlashThreshold,
+                   WidthTolerance,
+                   ClocksData,
+                   TrigCoinc,
+                   SweepSeeding);
+  }
 
-      unsigned int AccumIndex2 = GetAccumIndex(peakTime, minTime, BinWidth, BinWidth / 2.0);
+  //----------------------------------------------------------------------------
+  void RunFlashFinder(std::vector<recob::OpHit> const& HitVector,
+                      std::vector<recob::OpFlash>& FlashVector,
+                      std::vector<std::vector<int>>& AssocList,
+                      double const BinWidth,
+                      OpChannelGeometry const& geom,
+                      float const FlashThreshold,
+                      float const WidthTolerance,
+                      detinfo::DetectorClocksData const& ClocksData,
+                      float const TrigCoinc,
+                      bool const SweepSeeding)
+  {
+    OpFlashWorkspace Workspace;
+    RunFlashFinder(HitVector,
+                   FlashVector,
+                   AssocList,
+                   BinWidth,
+                   geom,
+                   FlashThreshold,
+                   WidthTolerance,
+                   ClocksData,
+                   TrigCoinc,
+                   SweepSeeding,
+                   Workspace);
+  }
 
-      // Extend accumulators if needed (2 always larger than 1)
-      if (AccumIndex2 >= Binned1.size()) {
-        std::cout << "Extending vectors to " << AccumIndex2 * 1.2 << std::endl;
-        Binned1.resize(AccumIndex2 * 1.2);
-        Binned2.resize(AccumIndex2 * 1.2);
-        Contributors1.resize(AccumIndex2 * 1.2);
-        Contributors2.resize(AccumIndex2 * 1.2);
-      }
+  //----------------------------------------------------------------------------
+  void RunFlashFinder(std::vector<recob::OpHit> const& HitVector,
+                      std::vector<recob::OpFlash>& FlashVector,
+                      std::vector<std::vector<int>>& AssocList,
+                      double const BinWidth,
+                      OpChannelGeometry const& geom,
+                      float const FlashThreshold,
+                      float const WidthTolerance,
+                      detinfo::DetectorClocksData const& ClocksData,
+                      float const TrigCoinc,
+                      bool const SweepSeeding,
+                      OpFlashWorkspace& Workspace)
+  {
+    // Fill the accumulators which hold broad-binned light yields
+    FillAccumulators(HitVector, BinWidth, FlashThreshold, SweepSeeding, Workspace);
 
-      size_t const hitIndex = &hit - &HitVector[0];
-
-      FillAccumulator(AccumIndex1,
-                      hitIndex,
-                      hit.PE(),
-                      FlashThreshold,
-                      Binned1,
-                      Contributors1,
-                      FlashesInAccumulator1);
-
-      FillAccumulator(AccumIndex2,
-                      hitIndex,
-                      hit.PE(),
-                      FlashThreshold,
-                      Binned2,
-                      Contributors2,
-                      FlashesInAccumulator2);
-
-    } // End loop over hits
-
-    // Now start to create flashes.
-    // First, need vector to keep track of which hits belong to which flashes
-    std::vector<std::vector<int>> HitsPerFlash;
-
-    //if (Frame == 1) writeHistogram(Binned1);
-
-    AssignHitsToFlash(FlashesInAccumulator1,
-                      FlashesInAccumulator2,
-                      Binned1,
-                      Binned2,
-                      Contributors1,
-                      Contributors2,
-                      HitVector,
-                      HitsPerFlash,
-                      FlashThreshold);
+    // Now start to create flashes, keeping track of which hits belong to which
+    AssignHitsToFlash(HitVector, FlashThreshold, Workspace);
 
     // Now we do the fine grained part.
     // Subdivide each flash into sub-flashes with overlaps within hit widths
     // (assumed wider than photon travel time)
-    std::vector<std::vector<int>> RefinedHitsPerFlash;
-    for (auto const& HitsThisFlash : HitsPerFlash)
-      RefineHitsInFlash(
-        HitsThisFlash, HitVector, RefinedHitsPerFlash, WidthTolerance, FlashThreshold);
+    RefineHitsInFlash(HitVector, WidthTolerance, FlashThreshold, Workspace);
 
     // Now we have all our hits assigned to a flash.
-    // Make the recob::OpFlash objects
-    for (auto const& HitsPerFlashVec : RefinedHitsPerFlash)
-      ConstructFlash(HitsPerFlashVec, HitVector, FlashVector, geom, ClocksData, TrigCoinc);
-
-    RemoveLateLight(FlashVector, RefinedHitsPerFlash);
+    // Make the recob::OpFlash objects; they are independent of each other,
+    // so they are made concurrently, each into its own slot
+    HitIndexLists const& RefinedHitsPerFlash = Workspace.RefinedHitsPerFlash;
+    size_t const NFlashes = RefinedHitsPerFlash.NLists();
+    size_t const BeginFlash = FlashVector.size();
+    FlashVector.resize(BeginFlash + NFlashes);
+    tbb::enumerable_thread_specific<FlashScratch> scratch;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, NFlashes),
+                      [&](tbb::blocked_range<size_t> const& range) {
+                        FlashScratch& threadScratch = scratch.local();
+                        for (size_t iFlash = range.begin(); iFlash != range.end(); ++iFlash)
+                          FlashVector[BeginFlash + iFlash] =
+                            MakeFlash(RefinedHitsPerFlash.Begin(iFlash),
+                                      RefinedHitsPerFlash.End(iFlash),
+                                      HitVector,
+                                      geom,
+                                      geom.NChannels(),
+                                      geom.Nplanes(),
+                                      ClocksData,
+                                      TrigCoinc,
+                                      threadScratch);
+                      });
+
+    // Remove the late light as RemoveLateLight does; the hits stay in place,
+    // and FlashOrder tells which list of hits each sorted flash has
+    std::vector<size_t>& FlashOrder = Workspace.FlashOrder;
+    sort_permutation(FlashVector.begin() + BeginFlash,
+                     FlashVector.end(),
+                     recob::OpFlashSortByTime(),
+                     FlashOrder);
+    Workspace.Permutation = FlashOrder;
+    apply_permutation(Workspace.Permutation, FlashVector.begin() + BeginFlash);
+
+    std::vector<bool>& MarkedForRemoval = Workspace.MarkedForRemoval;
+    MarkedForRemoval.assign(NFlashes, false);
+    MarkFlashesForRemoval(FlashVector, BeginFlash, MarkedForRemoval);
 
     //checkOnBeamFlash(FlashVector);
 
-    // Finally, write the association list.
-    // back_inserter tacks the result onto the end of AssocList
-    for (auto& HitIndicesThisFlash : RefinedHitsPerFlash)
-      AssocList.push_back(HitIndicesThisFlash);
+    // Finally, write the association list of the flashes we keep.
+    // The hit lists are tacked onto the end of AssocList
+    size_t NKept = 0;
+    for (size_t iFlash = 0; iFlash != NFlashes; ++iFlash) {
+      if (MarkedForRemoval[iFlash]) continue;
+      if (NKept != iFlash)
+        FlashVector[BeginFlash + NKept] = std::move(FlashVector[BeginFlash + iFlash]);
+      AssocList.emplace_back(RefinedHitsPerFlash.Begin(FlashOrder[iFlash]),
+                             RefinedHitsPerFlash.End(FlashOrder[iFlash]));
+      ++NKept;
+    }
+    FlashVector.erase(FlashVector.begin() + BeginFlash + NKept, FlashVector.end());
 
   } // End RunFlashFinder
 
+  //----------------------------------------------------------------------------
+  void RunFlashFinder(std::vector<recob::OpHit> const& HitVector,
+                      std::vector<recob::OpFlash>& FlashVector,
+                      std::vector<std::vector<int>>& AssocList,
+                      double const BinWidth,
+                      OpChannelGeometry const& geom,
+                      float const FlashThreshold,
+                      float const WidthTolerance,
+                      detinfo::DetectorClocksData const& ClocksData,
+                      float const TrigCoinc,
+                      bool const SweepSeeding,
+                      std::vector<unsigned int> const& ChannelPartition,
+                      std::vector<OpFlashWorkspace>& Workspaces)
+  {
+    size_t const NPartitions = Workspaces.size();
+
+    for (auto& Workspace : Workspaces) {
+      Workspace.PartitionHits.clear();
+      Workspace.PartitionHitIndex.clear();
+    }
+    for (size_t HitIndex = 0; HitIndex != HitVector.size(); ++HitIndex) {
+      unsigned int const channel = HitVector[HitIndex].OpChannel();
+      if (channel >= ChannelPartition.size() || ChannelPartition[channel] >= NPartitions)
+        throw cet::exception("OpFlashAlg")
+          << "No flash finding partition for optical channel " << channel << "\n";
+      OpFlashWorkspace& Workspace = Workspaces[ChannelPartition[channel]];
+      Workspace.PartitionHits.push_back(HitVector[HitIndex]);
+      Workspace.PartitionHitIndex.push_back(HitIndex);
+    }
+
+    // Each partition fills its own flashes, so that the result
+    // does not depend on which one finishes first
+    std::vector<std::vector<recob::OpFlash>> PartitionFlashes(NPartitions);
+    std::vector<std::vector<std::vector<int>>> PartitionAssocs(NPartitions);
+    tbb::parallel_for(size_t(0), NPartitions, [&](size_t const Partition) {
+      OpFlashWorkspace& Workspace = Workspaces[Partition];
+      if (Workspace.PartitionHits.empty()) return;
+      RunFlashFinder(Workspace.PartitionHits,
+                     PartitionFlashes[Partition],
+                     PartitionAssocs[Partition],
+                     BinWidth,
+                     geom,
+                     FlashThreshold,
+                     WidthTolerance,
+                     ClocksData,
+                     TrigCoinc,
+                     SweepSeeding,
+                     Workspace);
+      for (auto& HitIndices : PartitionAssocs[Partition])
+        for (int& HitIndex : HitIndices)
+          HitIndex = Workspace.PartitionHitIndex[HitIndex];
+    });
+
+    for (size_t Partition = 0; Partition != NPartitions; ++Partition) {
+      std::move(PartitionFlashes[Partition].begin(),
+                PartitionFlashes[Partition].end(),
+                std::back_inserter(FlashVector));
+      std::move(PartitionAssocs[Partition].begin(),
+                PartitionAssocs[Partition].end(),
+                std::back_inserter(AssocList));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void FillAccumulators(std::vector<recob::OpHit> const& HitVector,
+                        double const BinWidth,
+                        float const FlashThreshold,
+                        bool const SweepSeeding,
+                        OpFlashWorkspace& Workspace)
+  {
+    double minTime = std::numeric_limits<float>::max();
+    for (auto const& hit : HitVector)
+      if (hit.PeakTime() < minTime) minTime = hit.PeakTime();
+
+    if (SweepSeeding) {
+      SortHitsByTime(HitVector, Workspace.HitsByTime);
+      SweepAccumulator(Workspace.HitsByTime,
+                       HitVector,
+                       minTime,
+                       BinWidth,
+                       0.0,
+                       FlashThreshold,
+                       Workspace.Accumulator1,
+                       Workspace);
+      SweepAccumulator(Workspace.HitsByTime,
+                       HitVector,
+                       minTime,
+                       BinWidth,
+                       BinWidth / 2.0,
+                       FlashThreshold,
+                       Workspace.Accumulator2,
+                       Workspace);
+      return;
+    }
+
+    // Bins up to the last hit (the offset accumulator always reaches further)
+    unsigned int NBins = 0;
+    for (auto const& hit : HitVector)
+      NBins = std::max(NBins, GetAccumIndex(hit.PeakTime(), minTime, BinWidth, BinWidth / 2.0) + 1);
+
+    BinHits(
+      HitVector, minTime, BinWidth, 0.0, NBins, FlashThreshold, Workspace.Accumulator1, Workspace);
+    BinHits(HitVector,
+            minTime,
+            BinWidth,
+            BinWidth / 2.0,
+            NBins,
+            FlashThreshold,
+            Workspace.Accumulator2,
+            Workspace);
+  }
+
   //----------------------------------------------------------------------------
   unsigned int GetAccumIndex(double const PeakTime,
                              double const MinTime,
@@ -192,6 +471,155 @@ namespace opdet {
       FlashesInAccumulator.push_back(AccumIndex);
   }
 
+  //----------------------------------------------------------------------------
+  namespace {
+
+    void BinHits(std::vector<recob::OpHit> const& HitVector,
+                 double const MinTime,
+                 double const BinWidth,
+                 double const BinOffset,
+                 unsigned int const NBins,
+                 float const FlashThreshold,
+                 FlashAccumulator& Accumulator,
+                 OpFlashWorkspace& Workspace)
+    {
+      // The same sums and flashes as FillAccumulator for each hit in turn;
+      // the contributors of all the bins are then laid out in one pass
+      std::vector<double>& Binned = Accumulator.Binned;
+      std::vector<size_t>& Offsets = Accumulator.Contributors.Offsets;
+      std::vector<int>& Hits = Accumulator.Contributors.Hits;
+      Binned.assign(NBins, 0.0);
+      Offsets.assign(NBins + 1, 0);
+      Accumulator.FlashesInAccumulator.clear();
+
+      std::vector<unsigned int>& HitBins = Workspace.HitBins;
+      HitBins.resize(HitVector.size());
+      for (size_t HitIndex = 0; HitIndex != HitVector.size(); ++HitIndex)
+        HitBins[HitIndex] =
+          GetAccumIndex(HitVector[HitIndex].PeakTime(), MinTime, BinWidth, BinOffset);
+
+      for (size_t HitIndex = 0; HitIndex != HitVector.size(); ++HitIndex) {
+        unsigned int const AccumIndex = HitBins[HitIndex];
+        double const PE = HitVector[HitIndex].PE();
+
+        ++Offsets[AccumIndex + 1];
+        Binned[AccumIndex] += PE;
+
+        // If this wasn't a flash already, add it to the list
+        if (Binned[AccumIndex] >= FlashThreshold && (Binned[AccumIndex] - PE) < FlashThreshold)
+          Accumulator.FlashesInAccumulator.push_back(AccumIndex);
+      }
+
+      std::partial_sum(Offsets.begin(), Offsets.end(), Offsets.begin());
+      Hits.resize(HitVector.size());
+      for (size_t HitIndex = 0; HitIndex != HitVector.size(); ++HitIndex)
+        Hits[Offsets[HitBins[HitIndex]]++] = HitIndex;
+      // Offsets now point to the end of each bin; move them back to its start
+      std::copy_backward(Offsets.begin(), std::prev(Offsets.end()), Offsets.end());
+      Offsets[0] = 0;
+    }
+
+    void SortHitsByTime(std::vector<recob::OpHit> const& HitVector, std::vector<int>& HitsByTime)
+    {
+      HitsByTime.resize(HitVector.size());
+      std::iota(HitsByTime.begin(), HitsByTime.end(), 0);
+      std::sort(HitsByTime.begin(), HitsByTime.end(), [&HitVector](int i, int j) {
+        double const iTime = HitVector[i].PeakTime();
+        double const jTime = HitVector[j].PeakTime();
+        return iTime < jTime || (iTime == jTime && i < j);
+      });
+    }
+
+    void SweepAccumulator(std::vector<int> const& HitsByTime,
+                          std::vector<recob::OpHit> const& HitVector,
+                          double const MinTime,
+                          double const BinWidth,
+                          double const BinOffset,
+                          float const FlashThreshold,
+                          FlashAccumulator& Accumulator,
+                          OpFlashWorkspace& Workspace)
+    {
+      std::vector<double>& Binned = Accumulator.Binned;
+      Binned.clear();
+      Accumulator.Contributors.Clear();
+      Accumulator.FlashesInAccumulator.clear();
+
+      auto const accumIndex = [&](int const HitIndex) {
+        return GetAccumIndex(HitVector[HitIndex].PeakTime(), MinTime, BinWidth, BinOffset);
+      };
+
+      // (hit index, flash bin) for each threshold crossing: FillAccumulator
+      // records the flashes in the order of the hits that make them cross
+      std::vector<std::pair<int, int>>& Crossings = Workspace.Crossings;
+      std::vector<int>& HitsThisBin = Workspace.HitsThisBin;
+      Crossings.clear();
+
+      // The bin index never decreases along the sorted hits,
+      // so [begin, end) spans exactly the hits of one bin
+      size_t end = 0;
+      for (size_t begin = 0; begin != HitsByTime.size(); begin = end) {
+
+        unsigned int const AccumIndex = accumIndex(HitsByTime[begin]);
+        for (end = begin + 1; end != HitsByTime.size(); ++end)
+          if (accumIndex(HitsByTime[end]) != AccumIndex) break;
+
+        // Sum in the order of the hit vector, as FillAccumulator does,
+        // so that the bin content is the same to the last bit
+        HitsThisBin.assign(HitsByTime.begin() + begin, HitsByTime.begin() + end);
+        std::sort(HitsThisBin.begin(), HitsThisBin.end());
+
+        double PE = 0;
+        size_t const NCrossings = Crossings.size();
+        for (int const HitIndex : HitsThisBin) {
+          double const HitPE = HitVector[HitIndex].PE();
+          PE += HitPE;
+          if (PE >= FlashThreshold && (PE - HitPE) < FlashThreshold)
+            Crossings.emplace_back(HitIndex, Binned.size());
+        }
+
+        if (Crossings.size() == NCrossings) continue;
+
+        Binned.push_back(PE);
+        Accumulator.Contributors.Add(HitsThisBin.begin(), HitsThisBin.end());
+      }
+
+      std::sort(Crossings.begin(), Crossings.end());
+      for (auto const& Crossing : Crossings)
+        Accumulator.FlashesInAccumulator.push_back(Crossing.second);
+    }
+
+  } // local namespace
+
+  //----------------------------------------------------------------------------
+  std::vector<int> SortHitsByTime(std::vector<recob::OpHit> const& HitVector)
+  {
+    std::vector<int> HitsByTime;
+    SortHitsByTime(HitVector, HitsByTime);
+    return HitsByTime;
+  }
+
+  //----------------------------------------------------------------------------
+  void SweepAccumulator(std::vector<int> const& HitsByTime,
+                        std::vector<recob::OpHit> const& HitVector,
+                        double const MinTime,
+                        double const BinWidth,
+                        double const BinOffset,
+                        float const FlashThreshold,
+                        std::vector<double>& Binned,
+                        std::vector<std::vector<int>>& Contributors,
+                        std::vector<int>& FlashesInAccumulator)
+  {
+    OpFlashWorkspace Workspace;
+    FlashAccumulator& Accumulator = Workspace.Accumulator1;
+    SweepAccumulator(
+      HitsByTime, HitVector, MinTime, BinWidth, BinOffset, FlashThreshold, Accumulator, Workspace);
+
+    Binned = std::move(Accumulator.Binned);
+    Contributors.clear();
+    AppendVectors(Accumulator.Contributors, Contributors);
+    FlashesInAccumulator = std::move(Accumulator.FlashesInAccumulator);
+  }
+
   //----------------------------------------------------------------------------
   void FillFlashesBySizeMap(
     std::vector<int> const& FlashesInAccumulator,
@@ -248,42 +676,83 @@ namespace opdet {
                          std::vector<std::vector<int>>& HitsPerFlash,
                          float const FlashThreshold)
   {
-    // Sort all the flashes found by size. The structure is:
-    // FlashesBySize[flash size][accumulator_num] = [flash_index1, flash_index2...]
-    std::map<double, std::map<int, std::vector<int>>, std::greater<double>> FlashesBySize;
+    OpFlashWorkspace Workspace;
+    Workspace.Accumulator1.FlashesInAccumulator = FlashesInAccumulator1;
+    Workspace.Accumulator2.FlashesInAccumulator = FlashesInAccumulator2;
+    Workspace.Accumulator1.Binned = Binned1;
+    Workspace.Accumulator2.Binned = Binned2;
+    ToLists(Contributors1, Workspace.Accumulator1.Contributors);
+    ToLists(Contributors2, Workspace.Accumulator2.Contributors);
+
+    AssignHitsToFlash(HitVector, FlashThreshold, Workspace);
+
+    AppendVectors(Workspace.HitsPerFlash, HitsPerFlash);
+  }
 
-    // Sort the flashes by size using map
-    FillFlashesBySizeMap(FlashesInAccumulator1, Binned1, 1, FlashesBySize);
-    FillFlashesBySizeMap(FlashesInAccumulator2, Binned2, 2, FlashesBySize);
+  //----------------------------------------------------------------------------
+  void AssignHitsToFlash(std::vector<recob::OpHit> const& HitVector,
+                         float const FlashThreshold,
+                         OpFlashWorkspace& Workspace)
+  {
+    std::vector<int> const& FlashesInAccumulator1 = Workspace.Accumulator1.FlashesInAccumulator;
+    std::vector<int> const& FlashesInAccumulator2 = Workspace.Accumulator2.FlashesInAccumulator;
+    size_t const NFlashes1 = FlashesInAccumulator1.size();
+
+    // Sort all the flashes found by size, in the order of FillFlashesBySizeMap:
+    // flashes of the same size go by accumulator, then as found in it. Flash i
+    // is entry i of FlashesInAccumulator1, followed by FlashesInAccumulator2,
+    // so sorting by (size, i) gives that order.
+    std::vector<std::pair<double, int>>& FlashesBySize = Workspace.FlashesBySize;
+    FlashesBySize.clear();
+    for (size_t i = 0; i != NFlashes1; ++i)
+      FlashesBySize.emplace_back(Workspace.Accumulator1.Binned.at(FlashesInAccumulator1[i]), i);
+    for (size_t i = 0; i != FlashesInAccumulator2.size(); ++i)
+      FlashesBySize.emplace_back(Workspace.Accumulator2.Binned.at(FlashesInAccumulator2[i]),
+                                 NFlashes1 + i);
+    std::sort(FlashesBySize.begin(),
+              FlashesBySize.end(),
+              [](std::pair<double, int> const& a, std::pair<double, int> const& b) {
+                return a.first > b.first || (a.first == b.first && a.second < b.second);
+              });
 
     // This keeps track of which hits are claimed by which flash
-    std::vector<int> HitClaimedByFlash(HitVector.size(), -1);
+    std::vector<int>& HitClaimedByFlash = Workspace.HitClaimedByFlash;
+    HitClaimedByFlash.assign(HitVector.size(), -1);
+
+    HitIndexLists& HitsPerFlash = Workspace.HitsPerFlash;
+    HitsPerFlash.Clear();
+
+    std::vector<int>& HitsThisFlash = Workspace.HitsThisFlash;
 
     // Walk from largest to smallest, claiming hits.
     // The biggest flash always gets dibbs,
     // but we keep track of overlaps for re-merging later (do we? ---WK)
-    for (auto const& itFlash : FlashesBySize)
-      // If several with same size, walk through accumulators
-      for (auto const& itAcc : itFlash.second) {
+    for (auto const& Flash : FlashesBySize) {
 
-        int Accumulator = itAcc.first;
+      size_t const i = Flash.second;
+      bool const InAccumulator1 = i < NFlashes1;
+      HitIndexLists const& Contributors = InAccumulator1 ? Workspace.Accumulator1.Contributors :
+                                                           Workspace.Accumulator2.Contributors;
+      int const Bin =
+        InAccumulator1 ? FlashesInAccumulator1[i] : FlashesInAccumulator2[i - NFlashes1];
 
-        // Walk through flash-tagged bins in this accumulator
-        for (auto const& Bin : itAcc.second) {
+      // The hits of this bin not claimed yet, as FillHitsThisFlash
+      HitsThisFlash.clear();
+      for (int const* Hit = Contributors.Begin(Bin); Hit != Contributors.End(Bin); ++Hit)
+        if (HitClaimedByFlash[*Hit] == -1) HitsThisFlash.push_back(*Hit);
 
-          std::vector<int> HitsThisFlash;
+      // Store the flash and claim its hits, as ClaimHits
+      double PE = 0;
+      for (auto const& Hit : HitsThisFlash)
+        PE += HitVector[Hit].PE();
 
-          if (Accumulator == 1)
-            FillHitsThisFlash(Contributors1, Bin, HitClaimedByFlash, HitsThisFlash);
-          else if (Accumulator == 2)
-            FillHitsThisFlash(Contributors2, Bin, HitClaimedByFlash, HitsThisFlash);
+      if (PE < FlashThreshold) continue;
 
-          ClaimHits(HitVector, HitsThisFlash, FlashThreshold, HitsPerFlash, HitClaimedByFlash);
+      HitsPerFlash.Add(HitsThisFlash.begin(), HitsThisFlash.end());
+      for (auto const& Hit : HitsThisFlash)
+        HitClaimedByFlash[Hit] = HitsPerFlash.NLists() - 1;
 
-        } // End loop over this accumulator
-
-      } // End loops over accumulators
-    // End of loops over sorted flashes
+    } // End of loop over sorted flashes
 
   } // End AssignHitsToFlash
 
@@ -368,75 +837,206 @@ namespace opdet {
   } // End CheckAndStoreFlash
 
   //----------------------------------------------------------------------------
-  void RefineHitsInFlash(std::vector<int> const& HitsThisFlash,
-                         std::vector<recob::OpHit> const& HitVector,
-                         std::vector<std::vector<int>>& RefinedHitsPerFlash,
-                         float const WidthTolerance,
-                         float const FlashThreshold)
-  {
-    // Sort the hits by their size using map
-    // HitsBySize[HitSize] = [hit1, hit2 ...]
-    std::map<double, std::vector<int>, std::greater<double>> HitsBySize;
-    for (auto const& HitID : HitsThisFlash)
-      HitsBySize[HitVector.at(HitID).PE()].push_back(HitID);
-
-    // Heres what we do:
-    //  1.Start with the biggest remaining hit
-    //  2.Look for any within one width of this hit
-    //  3.Find the new upper and lower bounds of the flash
-    //  4.Collect again
-    //  5.Repeat until no new hits collected
-    //  6.Remove these hits from consideration and repeat
-
-    std::vector<bool> HitsUsed(HitVector.size(), false);
-    double PEAccumulated, FlashMaxTime, FlashMinTime;
-    std::vector<int> HitsThisRefinedFlash;
-
-    while (true) {
-
-      HitsThisRefinedFlash.clear();
-      PEAccumulated = 0;
-      FlashMaxTime = 0;
-      FlashMinTime = 0;
-
-      FindSeedHit(HitsBySize,
-                  HitsUsed,
-                  HitVector,
-                  HitsThisRefinedFlash,
-                  PEAccumulated,
-                  FlashMaxTime,
-                  FlashMinTime);
-
-      if (HitsThisRefinedFlash.size() == 0) return;
-
-      // Start this at zero to do the while at least once
-      size_t NHitsThisRefinedFlash = 0;
-
-      // If size of HitsThisRefinedFlash is same size,
-      // that means we're not adding anymore
-      while (NHitsThisRefinedFlash < HitsThisRefinedFlash.size()) {
-        NHitsThisRefinedFlash = HitsThisRefinedFlash.size();
-
-        for (auto const& itHit : HitsBySize)
-          for (auto const& HitID : itHit.second)
-            AddHitToFlash(HitID,
+  namespace {
+
+    // Refines the flash made of the hits [FirstHit, LastHit) into
+    // Workspace.RefinedHitsPerFlash, with its scratch buffers
+    void RefineHits(int const* const FirstHit,
+                    int const* const LastHit,
+                    std::vector<recob::OpHit> const& HitVector,
+                    float const WidthTolerance,
+                    float const FlashThreshold,
+                    OpFlashWorkspace& Workspace)
+    {
+      // Heres what we do:
+      //  1.Start with the biggest remaining hit
+      //  2.Look for any within one width of this hit
+      //  3.Find the new upper and lower bounds of the flash
+      //  4.Collect again
+      //  5.Repeat until no new hits collected
+      //  6.Remove these hits from consideration and repeat
+      //
+      // Hits are referred to by their position in the flash. Each collection
+      // pass visits the free hits in order of size, as a walk over all of them
+      // would, but only those close enough in time that AddHitToFlash could
+      // take them; these are found from the hits sorted by time.
+
+      size_t const NHits = LastHit - FirstHit;
+      auto const hit = [&](int const i) -> recob::OpHit const& { return HitVector.at(FirstHit[i]); };
+
+      // Hits from the biggest; equal sizes keep their order in the flash
+      std::vector<int>& BySize = Workspace.BySize;
+      BySize.resize(NHits);
+      std::iota(BySize.begin(), BySize.end(), 0);
+      std::stable_sort(BySize.begin(), BySize.end(), [&](int i, int j) {
+        return hit(i).PE() > hit(j).PE();
+      });
+      std::vector<int>& SizeRank = Workspace.SizeRank;
+      SizeRank.resize(NHits);
+      for (size_t r = 0; r != NHits; ++r)
+        SizeRank[BySize[r]] = r;
+
+      std::vector<int>& ByTime = Workspace.ByTime;
+      ByTime.resize(NHits);
+      std::iota(ByTime.begin(), ByTime.end(), 0);
+      std::stable_sort(ByTime.begin(), ByTime.end(), [&](int i, int j) {
+        return hit(i).PeakTime() < hit(j).PeakTime();
+      });
+      std::vector<size_t>& TimeRank = Workspace.TimeRank;
+      TimeRank.resize(NHits);
+      for (size_t t = 0; t != NHits; ++t)
+        TimeRank[ByTime[t]] = t;
+
+      double MaxHitWidth = 0;
+      for (size_t i = 0; i != NHits; ++i)
+        MaxHitWidth = std::max(MaxHitWidth, 0.5 * hit(i).Width());
+
+      std::vector<bool>& HitsUsed = Workspace.HitsUsed;
+      HitsUsed.assign(NHits, false);
+      double PEAccumulated, FlashMaxTime, FlashMinTime;
+      std::vector<int>& HitsThisRefinedFlash = Workspace.HitsThisRefinedFlash;
+
+      // Size ranks of the hits to visit in this pass (min-heap) and in the next
+      std::vector<int>& ThisPass = Workspace.ThisPass;
+      std::vector<int>& NextPass = Workspace.NextPass;
+      ThisPass.clear();
+      NextPass.clear();
+      std::greater<int> const smallest_first;
+
+      // The seed never goes back: all the bigger hits are in stored flashes
+      // or are seeds of discarded ones
+      for (size_t SeedRank = 0; SeedRank != NHits; ++SeedRank) {
+
+        int const Seed = BySize[SeedRank];
+        if (HitsUsed[Seed]) continue;
+
+        PEAccumulated = hit(Seed).PE();
+        FlashMaxTime = hit(Seed).PeakTime() + 0.5 * hit(Seed).Width();
+        FlashMinTime = hit(Seed).PeakTime() - 0.5 * hit(Seed).Width();
+        HitsThisRefinedFlash.assign(1, Seed);
+        HitsUsed[Seed] = true;
+
+        // Time ranks [Low, High) have already been queued or are used.
+        // The window in which a hit can be added only widens as the flash grows.
+        size_t Low = TimeRank[Seed];
+        size_t High = Low + 1;
+
+        // Queues the free hits that came into the window after adding the hit
+        // of size rank CurrentRank: bigger ones wait for the next pass
+        auto const queueNeighbours = [&](int const CurrentRank) {
+          double const Reach =
+            std::abs(WidthTolerance) * (MaxHitWidth + 0.5 * (FlashMaxTime - FlashMinTime));
+          // a little slack, so that rounding never leaves out a hit that
+          // AddHitToFlash would take
+          double const Slack = 1e-9 * (std::abs(FlashMinTime) + std::abs(FlashMaxTime) + Reach);
+          double const WindowLow = FlashMinTime - Reach - Slack;
+          double const WindowHigh = FlashMaxTime + Reach + Slack;
+
+          auto const queue = [&](int const i) {
+            if (HitsUsed[i]) return;
+            if (SizeRank[i] > CurrentRank) {
+              ThisPass.push_back(SizeRank[i]);
+              std::push_heap(ThisPass.begin(), ThisPass.end(), smallest_first);
+            }
+            else
+              NextPass.push_back(SizeRank[i]);
+          };
+          for (; Low != 0 && hit(ByTime[Low - 1]).PeakTime() >= WindowLow; --Low)
+            queue(ByTime[Low - 1]);
+          for (; High != NHits && hit(ByTime[High]).PeakTime() <= WindowHigh; ++High)
+            queue(ByTime[High]);
+        };
+
+        queueNeighbours(SeedRank);
+
+        while (true) {
+
+          bool HitsAdded = false;
+
+          while (!ThisPass.empty()) {
+            std::pop_heap(ThisPass.begin(), ThisPass.end(), smallest_first);
+            int const Rank = ThisPass.back();
+            ThisPass.pop_back();
+
+            size_t const NHitsThisRefinedFlash = HitsThisRefinedFlash.size();
+            AddHitToFlash(BySize[Rank],
                           HitsUsed,
-                          HitVector.at(HitID),
+                          hit(BySize[Rank]),
                           WidthTolerance,
                           HitsThisRefinedFlash,
                           PEAccumulated,
                           FlashMaxTime,
                           FlashMinTime);
-      }
 
-      // We did our collecting, now check if the flash is
-      // still good and push back
-      CheckAndStoreFlash(
-        RefinedHitsPerFlash, HitsThisRefinedFlash, PEAccumulated, FlashThreshold, HitsUsed);
+            if (HitsThisRefinedFlash.size() == NHitsThisRefinedFlash) {
+              NextPass.push_back(Rank);
+              continue;
+            }
+            HitsAdded = true;
+            queueNeighbours(Rank);
+          }
+
+          // If no hit was added, another pass would not add any either
+          if (!HitsAdded) break;
+
+          ThisPass.swap(NextPass);
+          std::make_heap(ThisPass.begin(), ThisPass.end(), smallest_first);
+        }
+        NextPass.clear();
+
+        // We did our collecting, now check if the flash is
+        // still good and store it; if not, release all hits but the seed
+        if (PEAccumulated >= FlashThreshold) {
+          HitIndexLists& RefinedHitsPerFlash = Workspace.RefinedHitsPerFlash;
+          for (int const i : HitsThisRefinedFlash)
+            RefinedHitsPerFlash.Hits.push_back(FirstHit[i]);
+          RefinedHitsPerFlash.Offsets.push_back(RefinedHitsPerFlash.Hits.size());
+        }
+        else {
+          for (auto it = std::next(HitsThisRefinedFlash.begin()); it != HitsThisRefinedFlash.end();
+               ++it)
+            HitsUsed[*it] = false;
+        }
+
+      } // End while there are hits left
+
+    } // End RefineHits
+
+  } // local namespace
 
-    } // End while there are hits left
+  //----------------------------------------------------------------------------
+  void RefineHitsInFlash(std::vector<int> const& HitsThisFlash,
+                         std::vector<recob::OpHit> const& HitVector,
+                         std::vector<std::vector<int>>& RefinedHitsPerFlash,
+                         float const WidthTolerance,
+                         float const FlashThreshold)
+  {
+    OpFlashWorkspace Workspace;
+    RefineHits(HitsThisFlash.data(),
+               HitsThisFlash.data() + HitsThisFlash.size(),
+               HitVector,
+               WidthTolerance,
+               FlashThreshold,
+               Workspace);
+    AppendVectors(Workspace.RefinedHitsPerFlash, RefinedHitsPerFlash);
+  }
 
-  } // End RefineHitsInFlash
+  //----------------------------------------------------------------------------
+  void RefineHitsInFlash(std::vector<recob::OpHit> const& HitVector,
+                         float const WidthTolerance,
+                         float const FlashThreshold,
+                         OpFlashWorkspace& Workspace)
+  {
+    HitIndexLists const& HitsPerFlash = Workspace.HitsPerFlash;
+    Workspace.RefinedHitsPerFlash.Clear();
+    for (size_t iFlash = 0; iFlash != HitsPerFlash.NLists(); ++iFlash)
+      RefineHits(HitsPerFlash.Begin(iFlash),
+                 HitsPerFlash.End(iFlash),
+                 HitVector,
+                 WidthTolerance,
+                 FlashThreshold,
+                 Workspace);
+  }
 
   //----------------------------------------------------------------------------
   void AddHitContribution(recob::OpHit const& currentHit,
@@ -494,6 +1094,34 @@ namespace opdet {
     sumz2 += PEThisHit * xyz.Z() * xyz.Z();
   }
 
+  //----------------------------------------------------------------------------
+  void GetHitGeometryInfo(recob::OpHit const& currentHit,
+                          OpChannelGeometry const& geom,
+                          std::vector<double>& sumw,
+                          std::vector<double>& sumw2,
+                          double& sumy,
+                          double& sumy2,
+                          double& sumz,
+                          double& sumz2)
+  {
+    unsigned int const channel = currentHit.OpChannel();
+    double PEThisHit = currentHit.PE();
+
+    // detectors outside the TPCs do not contribute to the average wire position
+    if (double const* wires = geom.Wires(channel)) {
+      for (size_t p = 0; p != geom.Nplanes(); ++p) {
+        sumw.at(p) += PEThisHit * wires[p];
+        sumw2.at(p) += PEThisHit * wires[p] * wires[p];
+      }
+    }
+    double const y = geom.Y(channel);
+    double const z = geom.Z(channel);
+    sumy += PEThisHit * y;
+    sumy2 += PEThisHit * y * y;
+    sumz += PEThisHit * z;
+    sumz2 += PEThisHit * z * z;
+  }
+
   //----------------------------------------------------------------------------
   double CalculateWidth(double const sum, double const sum_squared, double const weights_sum)
   {
@@ -503,6 +1131,97 @@ namespace opdet {
       return std::sqrt(sum_squared * weights_sum - sum * sum) / weights_sum;
   }
 
+  //----------------------------------------------------------------------------
+  namespace {
+
+    // Geometry is geo::GeometryCore or OpChannelGeometry.
+    // The PE of each channel is accumulated directly into the vector that the
+    // flash keeps; only the wire sums need a buffer, which the caller provides.
+    template <typename Geometry>
+    recob::OpFlash MakeFlash(int const* const FirstHit,
+                             int const* const LastHit,
+                             std::vector<recob::OpHit> const& HitVector,
+                             Geometry const& geom,
+                             unsigned int const NChannels,
+                             unsigned int const Nplanes,
+                             detinfo::DetectorClocksData const& ClocksData,
+                             float const TrigCoinc,
+                             FlashScratch& scratch)
+    {
+      double MaxTime = -std::numeric_limits<double>::max();
+      double MinTime = std::numeric_limits<double>::max();
+
+      std::vector<double> PEs(NChannels, 0.0);
+      std::vector<double>& sumw = scratch.sumw;
+      std::vector<double>& sumw2 = scratch.sumw2;
+      sumw.assign(Nplanes, 0.0);
+      sumw2.assign(Nplanes, 0.0);
+
+      double TotalPE = 0;
+      double AveTime = 0;
+      double AveAbsTime = 0;
+      double FastToTotal = 0;
+      double sumy = 0;
+      double sumz = 0;
+      double sumy2 = 0;
+      double sumz2 = 0;
+
+      for (int const* HitID = FirstHit; HitID != LastHit; ++HitID) {
+        AddHitContribution(
+          HitVector.at(*HitID), MaxTime, MinTime, AveTime, FastToTotal, AveAbsTime, TotalPE, PEs);
+        GetHitGeometryInfo(HitVector.at(*HitID), geom, sumw, sumw2, sumy, sumy2, sumz, sumz2);
+      }
+
+      AveTime /= TotalPE;
+      AveAbsTime /= TotalPE;
+      FastToTotal /= TotalPE;
+
+      double meany = sumy / TotalPE;
+      double meanz = sumz / TotalPE;
+
+      double widthy = CalculateWidth(sumy, sumy2, TotalPE);
+      double widthz = CalculateWidth(sumz, sumz2, TotalPE);
+
+      std::vector<double> WireCenters(Nplanes, 0.0);
+      std::vector<double> WireWidths(Nplanes, 0.0);
+
+      for (size_t p = 0; p != Nplanes; ++p) {
+        WireCenters.at(p) = sumw.at(p) / TotalPE;
+        WireWidths.at(p) = CalculateWidth(sumw.at(p), sumw2.at(p), TotalPE);
+      }
+
+      // Emprical corrections to get the Frame right.
+      // Eventual solution - remove frames
+      int Frame = ClocksData.OpticalClock().Frame(AveAbsTime - 18.1);
+      if (Frame == 0) Frame = 1;
+
+      int BeamFrame = ClocksData.OpticalClock().Frame(ClocksData.TriggerTime());
+      bool InBeamFrame = false;
+      if (!(ClocksData.TriggerTime() < 0)) InBeamFrame = (Frame == BeamFrame);
+
+      double TimeWidth = (MaxTime - MinTime) / 2.0;
+
+      int OnBeamTime = 0;
+      if (InBeamFrame && (std::abs(AveTime) < TrigCoinc)) OnBeamTime = 1;
+
+      return recob::OpFlash(AveTime,
+                            TimeWidth,
+                            AveAbsTime,
+                            Frame,
+                            std::move(PEs),
+                            InBeamFrame,
+                            OnBeamTime,
+                            FastToTotal,
+                            meany,
+                            widthy,
+                            meanz,
+                            widthz,
+                            std::move(WireCenters),
+                            std::move(WireWidths));
+    }
+
+  } // local namespace
+
   //----------------------------------------------------------------------------
   void ConstructFlash(std::vector<int> const& HitsPerFlashVec,
                       std::vector<recob::OpHit> const& HitVector,
@@ -511,75 +1230,36 @@ namespace opdet {
                       detinfo::DetectorClocksData const& ClocksData,
                       float const TrigCoinc)
   {
-    double MaxTime = -std::numeric_limits<double>::max();
-    double MinTime = std::numeric_limits<double>::max();
-
-    std::vector<double> PEs(geom.MaxOpChannel() + 1, 0.0);
-    unsigned int Nplanes = geom.Nplanes();
-    std::vector<double> sumw(Nplanes, 0.0);
-    std::vector<double> sumw2(Nplanes, 0.0);
-
-    double TotalPE = 0;
-    double AveTime = 0;
-    double AveAbsTime = 0;
-    double FastToTotal = 0;
-    double sumy = 0;
-    double sumz = 0;
-    double sumy2 = 0;
-    double sumz2 = 0;
-
-    for (auto const& HitID : HitsPerFlashVec) {
-      AddHitContribution(
-        HitVector.at(HitID), MaxTime, MinTime, AveTime, FastToTotal, AveAbsTime, TotalPE, PEs);
-      GetHitGeometryInfo(HitVector.at(HitID), geom, sumw, sumw2, sumy, sumy2, sumz, sumz2);
-    }
-
-    AveTime /= TotalPE;
-    AveAbsTime /= TotalPE;
-    FastToTotal /= TotalPE;
-
-    double meany = sumy / TotalPE;
-    double meanz = sumz / TotalPE;
-
-    double widthy = CalculateWidth(sumy, sumy2, TotalPE);
-    double widthz = CalculateWidth(sumz, sumz2, TotalPE);
-
-    std::vector<double> WireCenters(Nplanes, 0.0);
-    std::vector<double> WireWidths(Nplanes, 0.0);
-
-    for (size_t p = 0; p != Nplanes; ++p) {
-      WireCenters.at(p) = sumw.at(p) / TotalPE;
-      WireWidths.at(p) = CalculateWidth(sumw.at(p), sumw2.at(p), TotalPE);
-    }
+    FlashScratch scratch;
+    FlashVector.push_back(MakeFlash(HitsPerFlashVec.data(),
+                                    HitsPerFlashVec.data() + HitsPerFlashVec.size(),
+                                    HitVector,
+                                    geom,
+                                    geom.MaxOpChannel() + 1,
+                                    geom.Nplanes(),
+                                    ClocksData,
+                                    TrigCoinc,
+                                    scratch));
+  }
 
-    // Emprical corrections to get the Frame right.
-    // Eventual solution - remove frames
-    int Frame = ClocksData.OpticalClock().Frame(AveAbsTime - 18.1);
-    if (Frame == 0) Frame = 1;
-
-    int BeamFrame = ClocksData.OpticalClock().Frame(ClocksData.TriggerTime());
-    bool InBeamFrame = false;
-    if (!(ClocksData.TriggerTime() < 0)) InBeamFrame = (Frame == BeamFrame);
-
-    double TimeWidth = (MaxTime - MinTime) / 2.0;
-
-    int OnBeamTime = 0;
-    if (InBeamFrame && (std::abs(AveTime) < TrigCoinc)) OnBeamTime = 1;
-
-    FlashVector.emplace_back(AveTime,
-                             TimeWidth,
-                             AveAbsTime,
-                             Frame,
-                             PEs,
-                             InBeamFrame,
-                             OnBeamTime,
-                             FastToTotal,
-                             meany,
-                             widthy,
-                             meanz,
-                             widthz,
-                             WireCenters,
-                             WireWidths);
+  //----------------------------------------------------------------------------
+  void ConstructFlash(std::vector<int> const& HitsPerFlashVec,
+                      std::vector<recob::OpHit> const& HitVector,
+                      std::vector<recob::OpFlash>& FlashVector,
+                      OpChannelGeometry const& geom,
+                      detinfo::DetectorClocksData const& ClocksData,
+                      float const TrigCoinc)
+  {
+    FlashScratch scratch;
+    FlashVector.push_back(MakeFlash(HitsPerFlashVec.data(),
+                                    HitsPerFlashVec.data() + HitsPerFlashVec.size(),
+                                    HitVector,
+                                    geom,
+                                    geom.NChannels(),
+                                    geom.Nplanes(),
+                                    ClocksData,
+                                    TrigCoinc,
+                                    scratch));
   }
 
   //----------------------------------------------------------------------------
@@ -593,8 +1273,7 @@ namespace opdet {
     if (iTime > jTime) return 1e6;
 
     // Calculate hypothetical PE if this were actually a late flash from i.
-    // Argon time const is 1600 ns, so 1.6.
-    double HypPE = iPE * jWidth / iWidth * std::exp(-(jTime - iTime) / 1.6);
+    double HypPE = iPE * jWidth / iWidth * std::exp(-(jTime - iTime) / LateLightTimeConstant);
     double nsigma = (jPE - HypPE) / std::sqrt(HypPE);
     return nsigma;
   }
@@ -604,24 +1283,67 @@ namespace opdet {
                              size_t const BeginFlash,
                              std::vector<bool>& MarkedForRemoval)
   {
-    for (size_t iFlash = BeginFlash; iFlash != FlashVector.size(); ++iFlash) {
+    // A flash is late light if any earlier flash before it in the vector
+    // explains it. Rather than trying all pairs, each flash is compared only
+    // with the flashes that follow it closely enough in time for its late light
+    // to still matter.
+    size_t const NFlashes = FlashVector.size() - BeginFlash;
+
+    std::vector<double> Time(NFlashes), PE(NFlashes), Width(NFlashes);
+    double MaxWidth = 0;
+    double MinPE = std::numeric_limits<double>::max();
+    for (size_t i = 0; i != NFlashes; ++i) {
+      auto const& flash = FlashVector[BeginFlash + i];
+      Time[i] = flash.Time();
+      PE[i] = flash.TotalPE();
+      Width[i] = flash.TimeWidth();
+      MaxWidth = std::max(MaxWidth, Width[i]);
+      MinPE = std::min(MinPE, PE[i]);
+    }
+
+    // Flashes by time; flashes at the same time stay in vector order
+    std::vector<size_t> ByTime(NFlashes);
+    std::iota(ByTime.begin(), ByTime.end(), 0);
+    if (!std::is_sorted(Time.begin(), Time.end()))
+      std::stable_sort(ByTime.begin(), ByTime.end(), [&Time](size_t i, size_t j) {
+        return Time[i] < Time[j];
+      });
+
+    // Once HypPE + LateLightNSigma * sqrt(HypPE) is below the smallest flash,
+    // i.e. HypPE below SqrtLimit^2, no flash can be late light any more.
+    // The limit is halved to stay clear of rounding.
+    double const SqrtLimit =
+      0.5 * (std::sqrt(LateLightNSigma * LateLightNSigma + 4 * MinPE) - LateLightNSigma);
+    double const HypPELimit = 0.5 * SqrtLimit * SqrtLimit;
+
+    for (size_t iSorted = 0; iSorted != NFlashes; ++iSorted) {
 
-      double iTime = FlashVector.at(iFlash).Time();
-      double iPE = FlashVector.at(iFlash).TotalPE();
-      double iWidth = FlashVector.at(iFlash).TimeWidth();
+      size_t const iFlash = ByTime[iSorted];
 
-      for (size_t jFlash = iFlash + 1; jFlash != FlashVector.size(); ++jFlash) {
+      // With no width, HypPE is infinite or NaN and the test never passes
+      if (Width[iFlash] == 0) continue;
 
-        if (MarkedForRemoval.at(jFlash - BeginFlash)) continue;
+      // After this time HypPE is below the limit for any later flash.
+      // There is no limit if a flash has no PE, and a NaN one never stops the loop.
+      double LookAhead = std::numeric_limits<double>::infinity();
+      if (MinPE > 0)
+        LookAhead = LateLightTimeConstant *
+                    std::log(PE[iFlash] * MaxWidth / Width[iFlash] / HypPELimit);
 
-        double jTime = FlashVector.at(jFlash).Time();
-        double jPE = FlashVector.at(jFlash).TotalPE();
-        double jWidth = FlashVector.at(jFlash).TimeWidth();
+      for (size_t jSorted = iSorted + 1; jSorted != NFlashes; ++jSorted) {
+
+        size_t const jFlash = ByTime[jSorted];
+
+        if (Time[jFlash] - Time[iFlash] > LookAhead) break;
+
+        if (jFlash < iFlash || MarkedForRemoval.at(jFlash)) continue;
 
         // If smaller than, or within 2sigma of expectation,
         // attribute to late light and toss out
-        if (GetLikelihoodLateLight(iPE, iTime, iWidth, jPE, jTime, jWidth) < 3.0)
-          MarkedForRemoval.at(jFlash - BeginFlash) = true;
+        if (GetLikelihoodLateLight(
+              PE[iFlash], Time[iFlash], Width[iFlash], PE[jFlash], Time[jFlash], Width[jFlash]) <
+            LateLightNSigma)
+          MarkedForRemoval.at(jFlash) = true;
       }
     }
   }
@@ -632,11 +1354,21 @@ namespace opdet {
                                 size_t const BeginFlash,
                                 std::vector<std::vector<int>>& RefinedHitsPerFlash)
   {
-    for (int iFlash = MarkedForRemoval.size() - 1; iFlash != -1; --iFlash)
-      if (MarkedForRemoval.at(iFlash)) {
-        RefinedHitsPerFlash.erase(RefinedHitsPerFlash.begin() + iFlash);
-        FlashVector.erase(FlashVector.begin() + BeginFlash + iFlash);
+    // Move the flashes to keep forward in one pass, then drop the rest
+    size_t NKept = 0;
+    for (size_t iFlash = 0; iFlash != MarkedForRemoval.size(); ++iFlash) {
+      if (MarkedForRemoval[iFlash]) continue;
+      if (NKept != iFlash) {
+        RefinedHitsPerFlash.at(NKept) = std::move(RefinedHitsPerFlash.at(iFlash));
+        FlashVector.at(BeginFlash + NKept) = std::move(FlashVector.at(BeginFlash + iFlash));
       }
+      ++NKept;
+    }
+
+    RefinedHitsPerFlash.erase(RefinedHitsPerFlash.begin() + NKept,
+                              RefinedHitsPerFlash.begin() + MarkedForRemoval.size());
+    FlashVector.erase(FlashVector.begin() + BeginFlash + NKept,
+                      FlashVector.begin() + BeginFlash + MarkedForRemoval.size());
   }
 
   //----------------------------------------------------------------------------
@@ -647,15 +1379,10 @@ namespace opdet {
 
     size_t const BeginFlash = FlashVector.size() - RefinedHitsPerFlash.size();
 
-    recob::OpFlashSortByTime sort_flash_by_time;
-
-    // Determine the sort of FlashVector starting at BeginFlash
-    auto sort_order = sort_permutation(FlashVector, BeginFlash, sort_flash_by_time);
-
-    // Sort the RefinedHitsPerFlash in the same way as tail end of FlashVector
-    apply_permutation(RefinedHitsPerFlash, sort_order);
-
-    std::sort(FlashVector.begin() + BeginFlash, FlashVector.end(), sort_flash_by_time);
+    // Sort the tail end of FlashVector by time, and RefinedHitsPerFlash with it
+    auto sort_order = sort_permutation(
+      FlashVector.begin() + BeginFlash, FlashVector.end(), recob::OpFlashSortByTime());
+    apply_permutation(sort_order, FlashVector.begin() + BeginFlash, RefinedHitsPerFlash.begin());
 
     MarkFlashesForRemoval(FlashVector, BeginFlash, MarkedForRemoval);
 
@@ -663,26 +1390,4 @@ namespace opdet {
 
   } // End RemoveLateLight
 
-  //----------------------------------------------------------------------------
-  template <typename T, typename Compare>
-  std::vector<int> sort_permutation(std::vector<T> const& vec, int offset, Compare compare)
-  {
-
-    std::vector<int> p(vec.size() - offset);
-    std::iota(p.begin(), p.end(), 0);
-    std::sort(
-      p.begin(), p.end(), [&](int i, int j) { return compare(vec[i + offset], vec[j + offset]); });
-    return p;
-  }
-
-  //----------------------------------------------------------------------------
-  template <typename T>
-  void apply_permutation(std::vector<T>& vec, std::vector<int> const& p)
-  {
-
-    std::vector<T> sorted_vec(p.size());
-    std::transform(p.begin(), p.end(), sorted_vec.begin(), [&](int i) { return vec[i]; });
-    vec = sorted_vec;
-  }
-
 } // End namespace opdet
@@ -20,10 +20,115 @@ namespace geo {
 
 #include <functional>
 #include <map>
+#include <utility>
 #include <vector>
 
 namespace opdet {
 
+  /// Geometry of the optical channels as used to construct flashes: the centre
+  /// of the optical detector and, if it is inside a TPC, the nearest wire on
+  /// each plane. The table is built once per job and shared by all events; it
+  /// is not rebuilt, so it must not be used across a change of geometry.
+  class OpChannelGeometry {
+  public:
+    explicit OpChannelGeometry(geo::GeometryCore const& geom);
+
+    /// Detectors at the given (y, z) positions, one per channel, none of them
+    /// in a TPC (e.g. for tests).
+    OpChannelGeometry(unsigned int Nplanes, std::vector<double> Y, std::vector<double> Z);
+
+    /// Number of channels in the table (the highest channel number plus one).
+    unsigned int NChannels() const { return fY.size(); }
+    unsigned int Nplanes() const { return fNplanes; }
+
+    double Y(unsigned int channel) const { return fY[CheckedChannel(channel)]; }
+    double Z(unsigned int channel) const { return fZ[CheckedChannel(channel)]; }
+
+    /// Nearest wire on each plane, or nullptr if the detector is not in a TPC.
+    /// Throws if the detector is in a TPC but the wire lookup failed.
+    double const* Wires(unsigned int channel) const;
+
+  private:
+    enum ChannelStatus : char { kNoChannel, kNoTPC, kNoWire, kInTPC };
+
+    unsigned int fNplanes;
+    std::vector<ChannelStatus> fStatus;
+    std::vector<double> fY;
+    std::vector<double> fZ;
+    std::vector<double> fWires; ///< Nplanes entries per channel
+
+    /// Throws if the channel has no geometry.
+    unsigned int CheckedChannel(unsigned int channel) const;
+  };
+
+  /// Lists of hit indices stored one after the other (compressed sparse rows):
+  /// list i is Hits[Offsets[i]] up to Hits[Offsets[i + 1]].
+  struct HitIndexLists {
+    std::vector<size_t> Offsets{0};
+    std::vector<int> Hits;
+
+    size_t NLists() const { return Offsets.size() - 1; }
+    int const* Begin(size_t i) const { return Hits.data() + Offsets[i]; }
+    int const* End(size_t i) const { return Hits.data() + Offsets[i + 1]; }
+
+    /// Appends the list [first, last).
+    template <typename It>
+    void Add(It first, It last)
+    {
+      Hits.insert(Hits.end(), first, last);
+      Offsets.push_back(Hits.size());
+    }
+
+    /// Removes all the lists, keeping the memory.
+    void Clear()
+    {
+      Offsets.assign(1, 0);
+      Hits.clear();
+    }
+  };
+
+  /// One accumulator: the PE and the contributing hits of each time bin, and
+  /// the bins that reached the flash threshold, in the order they reached it.
+  struct FlashAccumulator {
+    std::vector<double> Binned;
+    HitIndexLists Contributors;
+    std::vector<int> FlashesInAccumulator;
+  };
+
+  /// Everything RunFlashFinder works on within one event. Each event
+  /// overwrites it all, so keeping one workspace from an event to the next
+  /// reuses its memory instead of allocating it again for every event.
+  struct OpFlashWorkspace {
+    FlashAccumulator Accumulator1; ///< bins starting at the earliest hit
+    FlashAccumulator Accumulator2; ///< bins offset by half a bin width
+    HitIndexLists HitsPerFlash;    ///< hits claimed by each accumulator flash
+    HitIndexLists RefinedHitsPerFlash;
+
+    // Scratch buffers of the stages
+    std::vector<unsigned int> HitBins;
+    std::vector<int> HitsByTime;
+    std::vector<std::pair<int, int>> Crossings;
+    std::vector<int> HitsThisBin;
+    std::vector<std::pair<double, int>> FlashesBySize;
+    std::vector<int> HitClaimedByFlash;
+    std::vector<int> HitsThisFlash;
+    std::vector<int> BySize;
+    std::vector<int> SizeRank;
+    std::vector<int> ByTime;
+    std::vector<size_t> TimeRank;
+    std::vector<bool> HitsUsed;
+    std::vector<int> HitsThisRefinedFlash;
+    std::vector<int> ThisPass;
+    std::vector<int> NextPass;
+    std::vector<size_t> FlashOrder;
+    std::vector<size_t> Permutation;
+    std::vector<bool> MarkedForRemoval;
+
+    // The hits of this workspace's partition, and their index in the event
+    std::vector<recob::OpHit> PartitionHits;
+    std::vector<int> PartitionHitIndex;
+  };
+
   void RunFlashFinder(std::vector<recob::OpHit> const&,
                       std::vector<recob::OpFlash>&,
                       std::vector<std::vector<int>>&,
@@ -32,7 +137,60 @@ namespace opdet {
                       float,
                       float,
                       detinfo::DetectorClocksData const&,
-                      float);
+                      float,
+                      bool SweepSeeding = false);
+
+  /// Same as above, with the channel geometry from a prebuilt table.
+  void RunFlashFinder(std::vector<recob::OpHit> const&,
+                      std::vector<recob::OpFlash>&,
+                      std::vector<std::vector<int>>&,
+                      double,
+                      OpChannelGeometry const&,
+                      float,
+                      float,
+                      detinfo::DetectorClocksData const&,
+                      float,
+                      bool SweepSeeding = false);
+
+  /// Same as above, working in the given workspace.
+  void RunFlashFinder(std::vector<recob::OpHit> const&,
+                      std::vector<recob::OpFlash>&,
+                      std::vector<std::vector<int>>&,
+                      double,
+                      OpChannelGeometry const&,
+                      float,
+                      float,
+                      detinfo::DetectorClocksData const&,
+                      float,
+                      bool SweepSeeding,
+                      OpFlashWorkspace& Workspace);
+
+  /// Same as above, with the optical channels split into independent
+  /// partitions (e.g. cryostats): the hits on channel c are only combined with
+  /// the hits of partition ChannelPartition[c]. The partitions are processed
+  /// concurrently, one per workspace; their flashes are added partition after
+  /// partition, so FlashVector is ordered by partition and only by time within
+  /// each. AssocList refers to the hits by their index in HitVector.
+  void RunFlashFinder(std::vector<recob::OpHit> const&,
+                      std::vector<recob::OpFlash>&,
+                      std::vector<std::vector<int>>&,
+                      double,
+                      OpChannelGeometry const&,
+                      float,
+                      float,
+                      detinfo::DetectorClocksData const&,
+                      float,
+                      bool SweepSeeding,
+                      std::vector<unsigned int> const& ChannelPartition,
+                      std::vector<OpFlashWorkspace>& Workspaces);
+
+  /// Fills both accumulators of the workspace, bin by bin (as FillAccumulator)
+  /// or with only the flash bins (as SweepAccumulator) if SweepSeeding is set.
+  void FillAccumulators(std::vector<recob::OpHit> const& HitVector,
+                        double BinWidth,
+                        float FlashThreshold,
+                        bool SweepSeeding,
+                        OpFlashWorkspace& Workspace);
 
   unsigned int GetAccumIndex(double PeakTime, double MinTime, double BinWidth, double BinOffset);
 
@@ -44,6 +202,26 @@ namespace opdet {
                        std::vector<std::vector<int>>& Contributors,
                        std::vector<int>& FlashesInAccumulator);
 
+  /// Indices of the hits, sorted by peak time (hit index breaks ties).
+  std::vector<int> SortHitsByTime(std::vector<recob::OpHit> const& HitVector);
+
+  /// Builds the flash bins of one accumulator in a single sweep over the
+  /// time-sorted hits, instead of filling every bin with FillAccumulator.
+  /// Only bins reaching FlashThreshold are stored, so Binned, Contributors
+  /// and FlashesInAccumulator are compact (entry k is the k-th flash bin found)
+  /// and scale with the number of hits rather than with the readout length.
+  /// Their sums, contributor order and flash order are those of the full
+  /// accumulator, and they can be passed to AssignHitsToFlash as they are.
+  void SweepAccumulator(std::vector<int> const& HitsByTime,
+                        std::vector<recob::OpHit> const& HitVector,
+                        double MinTime,
+                        double BinWidth,
+                        double BinOffset,
+                        float FlashThreshold,
+                        std::vector<double>& Binned,
+                        std::vector<std::vector<int>>& Contributors,
+                        std::vector<int>& FlashesInAccumulator);
+
   void AssignHitsToFlash(std::vector<int> const&,
                          std::vector<int> const&,
                          std::vector<double> const&,
@@ -54,6 +232,11 @@ namespace opdet {
                          std::vector<std::vector<int>>&,
                          float);
 
+  /// Same as above, from the accumulators of the workspace into its HitsPerFlash.
+  void AssignHitsToFlash(std::vector<recob::OpHit> const& HitVector,
+                         float FlashThreshold,
+                         OpFlashWorkspace& Workspace);
+
   void FillFlashesBySizeMap(
     std::vector<int> const& FlashesInAccumulator,
     std::vector<double> const& BinnedPE,
@@ -77,6 +260,13 @@ namespace opdet {
                          float WidthTolerance,
                          float FlashThreshold);
 
+  /// Refines each flash in the HitsPerFlash of the workspace, into its
+  /// RefinedHitsPerFlash.
+  void RefineHitsInFlash(std::vector<recob::OpHit> const& HitVector,
+                         float WidthTolerance,
+                         float FlashThreshold,
+                         OpFlashWorkspace& Workspace);
+
   void FindSeedHit(std::map<double, std::vector<int>, std::greater<double>> const& HitsBySize,
                    std::vector<bool>& HitsUsed,
                    std::vector<recob::OpHit> const& HitVector,
@@ -107,6 +297,13 @@ namespace opdet {
                       detinfo::DetectorClocksData const& data,
                       float TrigCoinc);
 
+  void ConstructFlash(std::vector<int> const& HitsPerFlashVec,
+                      std::vector<recob::OpHit> const& HitVector,
+                      std::vector<recob::OpFlash>& FlashVector,
+                      OpChannelGeometry const& geom,
+                      detinfo::DetectorClocksData const& data,
+                      float TrigCoinc);
+
   void AddHitContribution(recob::OpHit const& currentHit,
                           double& MaxTime,
                           double& MinTime,
@@ -125,6 +322,15 @@ namespace opdet {
                           double& sumz,
                           double& sumz2);
 
+  void GetHitGeometryInfo(recob::OpHit const& currentHit,
+                          OpChannelGeometry const& geom,
+                          std::vector<double>& sumw,
+                          std::vector<double>& sumw2,
+                          double& sumy,
+                          double& sumy2,
+                          double& sumz,
+                          double& sumz2);
+
   void RemoveLateLight(std::vector<recob::OpFlash>&, std::vector<std::vector<int>>&);
 
   double GetLikelihoodLateLight(double iPE,
@@ -143,12 +349,6 @@ namespace opdet {
                                 size_t BeginFlash,
                                 std::vector<std::vector<int>>& RefinedHitsPerFlash);
 
-  template <typename T, typename Compare>
-  std::vector<int> sort_permutation(std::vector<T> const& vec, int offset, Compare compare);
-
-  template <typename T>
-  void apply_permutation(std::vector<T>& vec, std::vector<int> const& p);
-
 } // End opdet namespace
 
 #endif
@@ -12,6 +12,9 @@
 #include "larana/OpticalDetector/OpFlashAlg.h"
 #include "larcore/CoreUtils/ServiceUtil.h"
 #include "larcore/Geometry/Geometry.h"
+#include "larcorealg/Geometry/GeometryCore.h"
+#include "larcorealg/Geometry/OpDetGeo.h"
+#include "larcorealg/Geometry/TPCGeo.h"
 #include "lardata/DetectorInfoServices/DetectorClocksService.h"
 #include "lardata/Utilities/AssociationUtil.h"
 #include "lardataobj/RecoBase/OpFlash.h"
@@ -25,13 +28,16 @@
 #include "art/Framework/Services/Registry/ServiceHandle.h"
 #include "canvas/Persistency/Common/Ptr.h"
 #include "canvas/Persistency/Common/PtrVector.h"
+#include "cetlib_except/exception.h"
 #include "fhiclcpp/ParameterSet.h"
 
 // ROOT includes
 
 // C++ Includes
+#include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace opdet {
 
@@ -51,6 +57,20 @@ namespace opdet {
     Float_t fFlashThreshold;
     Float_t fWidthTolerance;
     Double_t fTrigCoinc;
+    bool fSweepSeeding; // Seed flashes from time-sorted hits, not fixed-size accumulators
+
+    OpChannelGeometry fChannelGeometry; // Shared by all events
+
+    // Partition of each optical channel; flashes are found independently in
+    // each partition. Empty if all the channels are in one partition.
+    std::vector<unsigned int> fChannelPartition;
+
+    std::vector<OpFlashWorkspace> fWorkspaces; // One per partition, reused from event to event
+
+    // Fills fChannelPartition as configured, and returns the number of partitions
+    unsigned int PartitionChannels(geo::GeometryCore const& geom,
+                                   std::string const& partitionBy,
+                                   std::vector<std::vector<unsigned int>> const& opDetGroups);
   };
 
 }
@@ -63,7 +83,8 @@ namespace opdet {
 
   //----------------------------------------------------------------------------
   // Constructor
-  OpFlashFinder::OpFlashFinder(const fhicl::ParameterSet& pset) : EDProducer{pset}
+  OpFlashFinder::OpFlashFinder(const fhicl::ParameterSet& pset)
+    : EDProducer{pset}, fChannelGeometry{*lar::providerFrom<geo::Geometry>()}
   {
 
     // Indicate that the Input Module comes from .fcl
@@ -73,6 +94,12 @@ namespace opdet {
     fFlashThreshold = pset.get<float>("FlashThreshold");
     fWidthTolerance = pset.get<float>("WidthTolerance");
     fTrigCoinc = pset.get<double>("TrigCoinc");
+    fSweepSeeding = pset.get<bool>("SweepSeeding", false);
+
+    fWorkspaces.resize(PartitionChannels(
+      *lar::providerFrom<geo::Geometry>(),
+      pset.get<std::string>("PartitionBy", "none"),
+      pset.get<std::vector<std::vector<unsigned int>>>("OpDetGroups", {})));
 
     produces<std::vector<recob::OpFlash>>();
     produces<art::Assns<recob::OpFlash, recob::OpHit>>();
@@ -89,23 +116,37 @@ namespace opdet {
     // at the end of processing
     std::vector<std::vector<int>> assocList;
 
-    auto const& geometry(*lar::providerFrom<geo::Geometry>());
-
     auto const clock_data =
       art::ServiceHandle<detinfo::DetectorClocksService const>()->DataFor(evt);
 
     // Get OpHits from the event
     auto const opHitHandle = evt.getValidHandle<std::vector<recob::OpHit>>(fInputModule);
 
-    RunFlashFinder(*opHitHandle,
-                   *flashPtr,
-                   assocList,
-                   fBinWidth,
-                   geometry,
-                   fFlashThreshold,
-                   fWidthTolerance,
-                   clock_data,
-                   fTrigCoinc);
+    if (fChannelPartition.empty())
+      RunFlashFinder(*opHitHandle,
+                     *flashPtr,
+                     assocList,
+                     fBinWidth,
+                     fChannelGeometry,
+                     fFlashThreshold,
+                     fWidthTolerance,
+                     clock_data,
+                     fTrigCoinc,
+                     fSweepSeeding,
+                     fWorkspaces.front());
+    else
+      RunFlashFinder(*opHitHandle,
+                     *flashPtr,
+                     assocList,
+                     fBinWidth,
+                     fChannelGeometry,
+                     fFlashThreshold,
+                     fWidthTolerance,
+                     clock_data,
+                     fTrigCoinc,
+                     fSweepSeeding,
+                     fChannelPartition,
+                     fWorkspaces);
 
     // Make the associations which we noted we need
     for (size_t i = 0; i != assocList.size(); ++i) {
@@ -121,4 +162,83 @@ namespace opdet {
     evt.put(std::move(assnPtr));
   }
 
+  //----------------------------------------------------------------------------
+  unsigned int OpFlashFinder::PartitionChannels(
+    geo::GeometryCore const& geom,
+    std::string const& partitionBy,
+    std::vector<std::vector<unsigned int>> const& opDetGroups)
+  {
+    if (partitionBy == "none") return 1;
+
+    if (partitionBy != "cryostat" && partitionBy != "tpc" && partitionBy != "groups")
+      throw cet::exception("OpFlashFinder")
+        << "PartitionBy must be \"none\", \"cryostat\", \"tpc\" or \"groups\", not \""
+        << partitionBy << "\"\n";
+
+    // Partition of each optical detector
+    std::vector<unsigned int> opDetPartition(geom.NOpDets());
+    unsigned int nPartitions = 0;
+
+    if (partitionBy == "groups") {
+      // Detectors in no group make up one more partition
+      nPartitions = opDetGroups.size() + 1;
+      opDetPartition.assign(geom.NOpDets(), opDetGroups.size());
+      for (unsigned int group = 0; group != opDetGroups.size(); ++group)
+        for (unsigned int const opDet : opDetGroups[group]) {
+          if (opDet >= opDetPartition.size())
+            throw cet::exception("OpFlashFinder")
+              << "OpDetGroups: no optical detector " << opDet << "\n";
+          if (opDetPartition[opDet] != opDetGroups.size())
+            throw cet::exception("OpFlashFinder")
+              << "OpDetGroups: optical detector " << opDet << " is in groups "
+              << opDetPartition[opDet] << " and " << group << "\n";
+          opDetPartition[opDet] = group;
+        }
+    }
+    else {
+      // TPCs are numbered through all the cryostats
+      std::vector<unsigned int> firstTPC;
+      for (unsigned int cryostat = 0; cryostat != geom.Ncryostats(); ++cryostat) {
+        firstTPC.push_back(nPartitions);
+        nPartitions += (partitionBy == "tpc") ? geom.NTPC(geo::CryostatID(cryostat)) : 1;
+      }
+
+      for (unsigned int opDet = 0; opDet != geom.NOpDets(); ++opDet) {
+        auto const center = geom.OpDetGeoFromOpDet(opDet).GetCenter();
+        geo::CryostatID const cryostat = geom.PositionToCryostatID(center);
+        if (!cryostat.isValid)
+          throw cet::exception("OpFlashFinder")
+            << "Optical detector " << opDet << " is in no cryostat\n";
+
+        unsigned int partition = firstTPC[cryostat.Cryostat];
+        if (partitionBy == "tpc") {
+          // Detectors are often just outside the TPC they look into:
+          // those not in a TPC go with the closest one in their cryostat
+          geo::TPCID const tpc = geom.FindTPCAtPosition(center);
+          unsigned int closestTPC = tpc.isValid ? tpc.TPC : 0;
+          if (!tpc.isValid) {
+            double minDistance2 = std::numeric_limits<double>::max();
+            for (unsigned int t = 0; t != geom.NTPC(cryostat); ++t) {
+              double const distance2 =
+                (geom.TPC(geo::TPCID(cryostat, t)).GetCenter() - center).Mag2();
+              if (distance2 < minDistance2) {
+                minDistance2 = distance2;
+                closestTPC = t;
+              }
+            }
+          }
+          partition += closestTPC;
+        }
+        opDetPartition[opDet] = partition;
+      }
+    }
+
+    fChannelPartition.assign(geom.MaxOpChannel() + 1, 0);
+    for (unsigned int channel = 0; channel != fChannelPartition.size(); ++channel)
+      if (geom.IsValidOpChannel(channel))
+        fChannelPartition[channel] = opDetPartition[geom.OpDetFromOpChannel(channel)];
+
+    return nPartitions;
+  }
+
 } // namespace opdet
@@ -9,7 +9,7 @@
 
 #include "fhiclcpp/ParameterSet.h"
 
-#include <unordered_map>
+#include <algorithm>
 
 namespace pmtana {
 
@@ -56,40 +56,37 @@ namespace pmtana {
 
     Reset();
 
-    std::vector<double> cfd;
-    cfd.reserve(wf.size());
-
     // follow cfd procedure: invert waveform, multiply by constant fraction
     // add to delayed waveform.
+    _cfd.resize(wf.size());
     for (unsigned int k = 0; k < wf.size(); ++k) {
 
-      auto delayed = -1.0 * _F * ((float)wf.at(k) - mean_v.at(k));
+      auto delayed = -1.0 * _F * ((float)wf[k] - mean_v[k]);
 
       if ((int)k < _D)
 
-        cfd.push_back(delayed);
+        _cfd[k] = delayed;
 
       else
 
-        cfd.push_back(delayed + ((float)wf.at(k - _D) - mean_v.at(k)));
+        _cfd[k] = delayed + ((float)wf[k - _D] - mean_v[k]);
     }
 
     // Get the zero point crossings, how can I tell which are meaningful?
     // go to each crossing, see if waveform is above pedestal (high above pedestal)
 
-    auto crossings = LinearZeroPointX(cfd);
+    LinearZeroPointX(_cfd, _crossings);
 
     // lambda criteria to determine if inside pulse
 
     auto in_peak = [&wf, &sigma_v, &mean_v](int i, float thresh) -> bool {
-      return wf.at(i) > sigma_v.at(i) * thresh + mean_v.at(i);
+      return wf[i] > sigma_v[i] * thresh + mean_v[i];
     };
 
     // loop over CFD crossings
-    for (const auto& cross : crossings) {
+    for (const auto& cross : _crossings) {
 
       if (in_peak(cross.first, _peak_thresh)) {
-        _pulse.reset_param();
 
         int i = cross.first;
 
@@ -101,6 +98,17 @@ namespace pmtana {
             break;
           }
         }
+
+        // Vic:
+        // Very close in time pulses have multiple CFD
+        // crossing points. Should we check that pulses now have
+        // some multiplicity? No lets just delete them.
+        // Walking back from a later crossing can't end before the start found
+        // from an earlier one, so the starts never decrease: a repeated start
+        // is the same pulse as the previous one, which is kept.
+        if (!_pulse_v.empty() && _pulse_v.back().t_start == i) continue;
+
+        _pulse.reset_param();
         _pulse.t_start = i;
 
         //walk a little further backwards to see if we can get 5 low RMS
@@ -154,8 +162,8 @@ namespace pmtana {
 
         //x
 
-        auto start_ped = mean_v.at(_pulse.t_start);
-        auto end_ped = mean_v.at(_pulse.t_end);
+        auto start_ped = mean_v[_pulse.t_start];
+        auto end_ped = mean_v[_pulse.t_end];
 
         //just take the "smaller one"
         _pulse.ped_mean = start_ped <= end_ped ? start_ped : end_ped;
@@ -169,71 +177,30 @@ namespace pmtana {
         _pulse.t_cfdcross = cross.second;
 
         for (auto k = _pulse.t_start; k <= _pulse.t_end; ++k) {
-          auto a = wf.at(k) - _pulse.ped_mean;
+          auto a = wf[k] - _pulse.ped_mean;
           if (a > 0) _pulse.area += a;
         }
 
         if (_risetime_calc_ptr)
-          _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-            {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-            {mean_v.begin() + _pulse.t_start, mean_v.begin() + _pulse.t_end},
-            true);
+          _pulse.t_rise = RiseTime(wf, mean_v, _pulse.t_start, _pulse.t_end, true);
 
         _pulse_v.push_back(_pulse);
       }
     }
 
-    // Vic:
-    // Very close in time pulses have multiple CFD
-    // crossing points. Should we check that pulses now have
-    // some multiplicity? No lets just delete them.
-
-    auto pulses_copy = _pulse_v;
-    _pulse_v.clear();
-
-    std::unordered_map<unsigned, pulse_param> delta;
-
-    //unsigned width = 0;
-    for (const auto& p : pulses_copy) {
-
-      if (delta.count(p.t_start)) {
-        if ((p.t_end - p.t_start) > (delta[p.t_start].t_end - delta[p.t_start].t_start))
-          delta[p.t_start] = p;
-        else
-          continue;
-      }
-      else {
-        delta[p.t_start] = p;
-      }
-    }
-
-    for (const auto& p : delta)
-      _pulse_v.push_back(p.second);
-
-    //do the same now ensure t_final's are all unique
-    //width = 0;
-
-    pulses_copy.clear();
-    pulses_copy = _pulse_v;
-
-    _pulse_v.clear();
-    delta.clear();
-
-    for (const auto& p : pulses_copy) {
-
-      if (delta.count(p.t_end)) {
-        if ((p.t_end - p.t_start) > (delta[p.t_end].t_end - delta[p.t_end].t_start))
-          delta[p.t_end] = p;
-        else
-          continue;
-      }
-      else {
-        delta[p.t_end] = p;
-      }
-    }
+    // Pulses now have unique starts; among those ending at the same sample
+    // keep the widest one, that is the earliest start, then restore time order
+    auto by_end = [](const pulse_param& a, const pulse_param& b) {
+      return a.t_end < b.t_end || (a.t_end == b.t_end && a.t_start < b.t_start);
+    };
+    auto same_end = [](const pulse_param& a, const pulse_param& b) { return a.t_end == b.t_end; };
+    auto by_start = [](const pulse_param& a, const pulse_param& b) { return a.t_start < b.t_start; };
 
-    for (const auto& p : delta)
-      _pulse_v.push_back(p.second);
+    if (!std::is_sorted(_pulse_v.begin(), _pulse_v.end(), by_end))
+      std::sort(_pulse_v.begin(), _pulse_v.end(), by_end);
+    _pulse_v.erase(std::unique(_pulse_v.begin(), _pulse_v.end(), same_end), _pulse_v.end());
+    if (!std::is_sorted(_pulse_v.begin(), _pulse_v.end(), by_start))
+      std::sort(_pulse_v.begin(), _pulse_v.end(), by_start);
 
     //there should be no overlapping pulses now...
 
@@ -241,16 +208,19 @@ namespace pmtana {
   }
 
   // currently returns ALL zero point crossings, we really just want ones associated with peak...
-  const std::map<unsigned, double> AlgoCFD::LinearZeroPointX(const std::vector<double>& trace)
+  //***************************************************************
+  void AlgoCFD::LinearZeroPointX(const std::vector<double>& trace,
+                                 std::vector<std::pair<unsigned, double>>& crossing) const
+  //***************************************************************
   {
 
-    std::map<unsigned, double> crossing;
+    crossing.clear();
 
     //step through the trace and find where slope is POSITIVE across zero
-    for (unsigned i = 0; i < trace.size() - 1; ++i) {
+    for (unsigned i = 0; i + 1 < trace.size(); ++i) {
 
-      auto si = ::pmtana::sign(trace.at(i));
-      auto sf = ::pmtana::sign(trace.at(i + 1));
+      auto si = ::pmtana::sign(trace[i]);
+      auto sf = ::pmtana::sign(trace[i + 1]);
 
       if (si == sf) //no sign flip, no zero cross
         continue;
@@ -260,10 +230,8 @@ namespace pmtana {
 
       //calculate the crossing X based on linear interpolation bt two pts
 
-      crossing[i] = (double)i - trace.at(i) * (1.0 / (trace.at(i + 1) - trace.at(i)));
+      crossing.emplace_back(i, (double)i - trace[i] * (1.0 / (trace[i + 1] - trace[i])));
     }
-
-    return crossing;
   }
 
 }
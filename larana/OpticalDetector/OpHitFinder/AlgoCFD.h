@@ -23,8 +23,8 @@ namespace fhicl {
 
 #include "larana/OpticalDetector/OpHitFinder/OpticalRecoTypes.h"
 
-#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace pmtana {
@@ -54,7 +54,10 @@ namespace pmtana {
                    const pmtana::PedestalMean_t&,
                    const pmtana::PedestalSigma_t&);
 
-    const std::map<unsigned, double> LinearZeroPointX(const std::vector<double>& trace);
+    /// Fills crossing with the (sample, interpolated position) of the positive-slope
+    /// zero crossings of trace, in increasing order
+    void LinearZeroPointX(const std::vector<double>& trace,
+                          std::vector<std::pair<unsigned, double>>& crossing) const;
 
   private:
     float _F;
@@ -64,6 +67,10 @@ namespace pmtana {
     double _peak_thresh;
     double _start_thresh;
     double _end_thresh;
+
+    /// CFD trace and its crossings, reused across waveforms
+    std::vector<double> _cfd;
+    std::vector<std::pair<unsigned, double>> _crossings;
   };
 
 }
@@ -87,10 +87,7 @@ namespace pmtana {
       _pulse_v[0].area - (_pulse_v[0].t_end - _pulse_v[0].t_start + 1) * mean_v.front();
 
     if (_risetime_calc_ptr)
-      _pulse_v[0].t_rise = _risetime_calc_ptr->RiseTime(
-        {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-        {mean_v.begin() + _pulse.t_start, mean_v.begin() + _pulse.t_end},
-        true);
+      _pulse_v[0].t_rise = RiseTime(wf, mean_v, _pulse.t_start, _pulse.t_end, true);
 
     return true;
   }
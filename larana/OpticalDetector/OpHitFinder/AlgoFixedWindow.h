@@ -50,6 +50,9 @@ namespace pmtana {
     /// Implementation of AlgoFixedWindow::reset() method
     void Reset();
 
+    /// The window is set in waveform ticks: each chunk would make a pulse of its own
+    bool SupportsChunking() const override { return false; }
+
   protected:
     /// Implementation of AlgoFixedWindow::reco() method
     bool RecoPulse(const pmtana::Waveform_t&,
@@ -70,10 +70,7 @@ namespace pmtana {
         _pulse.t_end = counter - 1;
         if (record_hit && ((_pulse.t_end - _pulse.t_start) >= _min_width)) {
           if (_risetime_calc_ptr)
-            _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-              {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-              {ped_mean.begin() + _pulse.t_start, ped_mean.begin() + _pulse.t_end},
-              true);
+            _pulse.t_rise = RiseTime(wf, ped_mean, _pulse.t_start, _pulse.t_end, true);
 
           _pulse_v.push_back(_pulse);
           record_hit = false;
@@ -107,10 +104,7 @@ namespace pmtana {
       _pulse.t_end = counter - 1;
       if (record_hit && ((_pulse.t_end - _pulse.t_start) >= _min_width)) {
         if (_risetime_calc_ptr)
-          _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-            {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-            {ped_mean.begin() + _pulse.t_start, ped_mean.begin() + _pulse.t_end},
-            true);
+          _pulse.t_rise = RiseTime(wf, ped_mean, _pulse.t_start, _pulse.t_end, true);
 
         _pulse_v.push_back(_pulse);
         record_hit = false;
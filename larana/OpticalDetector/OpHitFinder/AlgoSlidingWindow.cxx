@@ -117,10 +117,7 @@ namespace pmtana {
           // Register if width is acceptable
           if ((_pulse.t_end - _pulse.t_start) >= _min_width) {
             if (_risetime_calc_ptr)
-              _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-                {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-                {mean_v.begin() + _pulse.t_start, mean_v.begin() + _pulse.t_end},
-                _positive);
+              _pulse.t_rise = RiseTime(wf, mean_v, _pulse.t_start, _pulse.t_end, _positive);
 
             _pulse_v.push_back(_pulse);
           }
@@ -169,10 +166,7 @@ namespace pmtana {
           // Register if width is acceptable
           if ((_pulse.t_end - _pulse.t_start) >= _min_width) {
             if (_risetime_calc_ptr)
-              _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-                {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-                {mean_v.begin() + _pulse.t_start, mean_v.begin() + _pulse.t_end},
-                _positive);
+              _pulse.t_rise = RiseTime(wf, mean_v, _pulse.t_start, _pulse.t_end, _positive);
 
             _pulse_v.push_back(_pulse);
           }
@@ -236,10 +230,7 @@ namespace pmtana {
         // Register if width is acceptable
         if ((_pulse.t_end - _pulse.t_start) >= _min_width) {
           if (_risetime_calc_ptr)
-            _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-              {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-              {mean_v.begin() + _pulse.t_start, mean_v.begin() + _pulse.t_end},
-              _positive);
+            _pulse.t_rise = RiseTime(wf, mean_v, _pulse.t_start, _pulse.t_end, _positive);
 
           _pulse_v.push_back(_pulse);
         }
@@ -285,10 +276,7 @@ namespace pmtana {
       // Register if width is acceptable
       if ((_pulse.t_end - _pulse.t_start) >= _min_width) {
         if (_risetime_calc_ptr)
-          _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-            {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-            {mean_v.begin() + _pulse.t_start, mean_v.begin() + _pulse.t_end},
-            _positive);
+          _pulse.t_rise = RiseTime(wf, mean_v, _pulse.t_start, _pulse.t_end, _positive);
         _pulse_v.push_back(_pulse);
       }
 
@@ -101,10 +101,7 @@ namespace pmtana {
         _pulse.t_end = counter < wf.size() ? counter : counter - 1;
 
         if (_risetime_calc_ptr)
-          _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-            {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-            {mean_v.begin() + _pulse.t_start, mean_v.begin() + _pulse.t_end},
-            true);
+          _pulse.t_rise = RiseTime(wf, mean_v, _pulse.t_start, _pulse.t_end, true);
 
         _pulse_v.push_back(_pulse);
 
@@ -141,10 +138,7 @@ namespace pmtana {
       _pulse.t_end = counter - 1;
 
       if (_risetime_calc_ptr)
-        _pulse.t_rise = _risetime_calc_ptr->RiseTime(
-          {wf.begin() + _pulse.t_start, wf.begin() + _pulse.t_end},
-          {mean_v.begin() + _pulse.t_start, mean_v.begin() + _pulse.t_end},
-          true);
+        _pulse.t_rise = RiseTime(wf, mean_v, _pulse.t_start, _pulse.t_end, true);
 
       _pulse_v.push_back(_pulse);
 
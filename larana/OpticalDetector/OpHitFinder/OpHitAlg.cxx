@@ -13,6 +13,7 @@
 
 #include "OpHitAlg.h"
 
+#include "larana/OpticalDetector/OpHitFinder/OpticalRecoException.h"
 #include "larana/OpticalDetector/OpHitFinder/PulseRecoManager.h"
 #include "larcorealg/Geometry/GeometryCore.h"
 #include "lardataalg/DetectorInfo/DetectorClocks.h"
@@ -22,9 +23,158 @@
 #include "larreco/Calibrator/IPhotonCalibrator.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
+#include "tbb/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <vector>
 
+namespace {
+
+  //----------------------------------------------------------------------------
+  void FindHitsInWaveform(raw::OpDetWaveform const& waveform,
+                          std::vector<recob::OpHit>& hitVector,
+                          pmtana::PulseRecoManager const& pulseRecoMgr,
+                          pmtana::PMTPulseRecoBase const& threshAlg,
+                          geo::GeometryCore const& geometry,
+                          float hitThreshold,
+                          detinfo::DetectorClocksData const& clocksData,
+                          calib::IPhotonCalibrator const& calibrator,
+                          bool use_start_time)
+  {
+    const int channel = static_cast<int>(waveform.ChannelNumber());
+
+    if (!geometry.IsValidOpChannel(channel)) {
+      mf::LogError("OpHitFinder")
+        << "Error! unrecognized channel number " << channel << ". Ignoring pulse";
+      return;
+    }
+
+    pulseRecoMgr.Reconstruct(waveform);
+
+    // Get the result
+    auto const& pulses = threshAlg.GetPulses();
+
+    const double timeStamp = waveform.TimeStamp();
+
+    for (auto const& pulse : pulses)
+      opdet::ConstructHit(hitThreshold,
+                          channel,
+                          timeStamp,
+                          pulse,
+                          hitVector,
+                          clocksData,
+                          calibrator,
+                          use_start_time);
+  }
+
+  //----------------------------------------------------------------------------
+  raw::OpDetWaveform const& AsWaveform(raw::OpDetWaveform const& waveform)
+  {
+    return waveform;
+  }
+
+  raw::OpDetWaveform const& AsWaveform(raw::OpDetWaveform const* waveform)
+  {
+    return *waveform;
+  }
+
+  //----------------------------------------------------------------------------
+  // Waveforms is a vector of either waveforms or pointers to them
+  template <typename Waveforms>
+  void RunHitFinderSerial(Waveforms const& opDetWaveformVector,
+                          std::vector<recob::OpHit>& hitVector,
+                          pmtana::PulseRecoManager const& pulseRecoMgr,
+                          pmtana::PMTPulseRecoBase const& threshAlg,
+                          geo::GeometryCore const& geometry,
+                          float hitThreshold,
+                          detinfo::DetectorClocksData const& clocksData,
+                          calib::IPhotonCalibrator const& calibrator,
+                          bool use_start_time)
+  {
+
+    for (auto const& waveform : opDetWaveformVector)
+      FindHitsInWaveform(AsWaveform(waveform),
+                         hitVector,
+                         pulseRecoMgr,
+                         threshAlg,
+                         geometry,
+                         hitThreshold,
+                         clocksData,
+                         calibrator,
+                         use_start_time);
+  }
+
+  //----------------------------------------------------------------------------
+  template <typename Waveforms>
+  void RunHitFinderWorkers(Waveforms const& opDetWaveformVector,
+                           std::vector<recob::OpHit>& hitVector,
+                           std::vector<opdet::HitFinderWorker>& workers,
+                           geo::GeometryCore const& geometry,
+                           float hitThreshold,
+                           detinfo::DetectorClocksData const& clocksData,
+                           calib::IPhotonCalibrator const& calibrator,
+                           bool use_start_time)
+  {
+    if (workers.empty()) throw pmtana::OpticalRecoException("RunHitFinder: no hit finder worker!");
+
+    if (workers.size() == 1) {
+      RunHitFinderSerial(opDetWaveformVector,
+                         hitVector,
+                         workers.front().PulseRecoMgr(),
+                         workers.front().ThreshAlg(),
+                         geometry,
+                         hitThreshold,
+                         clocksData,
+                         calibrator,
+                         use_start_time);
+      return;
+    }
+
+    // Each waveform gets its own output slot, so that the merge below
+    // reproduces the serial order regardless of which thread did what
+    std::vector<std::vector<recob::OpHit>> hitsPerWaveform(opDetWaveformVector.size());
+
+    // Workers pull the next waveform from a shared counter until none is left
+    std::atomic<std::size_t> nextWaveform{0};
+
+    tbb::parallel_for(std::size_t{0}, workers.size(), [&](std::size_t iWorker) {
+      auto const& worker = workers[iWorker];
+      for (std::size_t i = nextWaveform++; i < opDetWaveformVector.size(); i = nextWaveform++)
+        FindHitsInWaveform(AsWaveform(opDetWaveformVector[i]),
+                           hitsPerWaveform[i],
+                           worker.PulseRecoMgr(),
+                           worker.ThreshAlg(),
+                           geometry,
+                           hitThreshold,
+                           clocksData,
+                           calibrator,
+                           use_start_time);
+    });
+
+    std::size_t nHits = hitVector.size();
+    for (auto const& hits : hitsPerWaveform)
+      nHits += hits.size();
+    hitVector.reserve(nHits);
+
+    for (auto& hits : hitsPerWaveform)
+      std::move(hits.begin(), hits.end(), std::back_inserter(hitVector));
+  }
+
+} // local namespace
+
 namespace opdet {
+
+  //----------------------------------------------------------------------------
+  HitFinderWorker::HitFinderWorker(std::unique_ptr<pmtana::PMTPulseRecoBase> threshAlg,
+                                   std::unique_ptr<pmtana::PMTPedestalBase> pedAlg)
+    : fThreshAlg{std::move(threshAlg)}, fPedAlg{std::move(pedAlg)}
+  {
+    fPulseRecoMgr.AddRecoAlgo(fThreshAlg.get());
+    fPulseRecoMgr.SetDefaultPedAlgo(fPedAlg.get());
+  }
+
   //----------------------------------------------------------------------------
   void RunHitFinder(std::vector<raw::OpDetWaveform> const& opDetWaveformVector,
                     std::vector<recob::OpHit>& hitVector,
@@ -36,34 +186,77 @@ namespace opdet {
                     calib::IPhotonCalibrator const& calibrator,
                     bool use_start_time)
   {
+    RunHitFinderSerial(opDetWaveformVector,
+                       hitVector,
+                       pulseRecoMgr,
+                       threshAlg,
+                       geometry,
+                       hitThreshold,
+                       clocksData,
+                       calibrator,
+                       use_start_time);
+  }
 
-    for (auto const& waveform : opDetWaveformVector) {
-
-      const int channel = static_cast<int>(waveform.ChannelNumber());
-
-      if (!geometry.IsValidOpChannel(channel)) {
-        mf::LogError("OpHitFinder")
-          << "Error! unrecognized channel number " << channel << ". Ignoring pulse";
-        continue;
-      }
-
-      pulseRecoMgr.Reconstruct(waveform);
-
-      // Get the result
-      auto const& pulses = threshAlg.GetPulses();
+  //----------------------------------------------------------------------------
+  void RunHitFinder(std::vector<raw::OpDetWaveform const*> const& opDetWaveformPtrs,
+                    std::vector<recob::OpHit>& hitVector,
+                    pmtana::PulseRecoManager const& pulseRecoMgr,
+                    pmtana::PMTPulseRecoBase const& threshAlg,
+                    geo::GeometryCore const& geometry,
+                    float hitThreshold,
+                    detinfo::DetectorClocksData const& clocksData,
+                    calib::IPhotonCalibrator const& calibrator,
+                    bool use_start_time)
+  {
+    RunHitFinderSerial(opDetWaveformPtrs,
+                       hitVector,
+                       pulseRecoMgr,
+                       threshAlg,
+                       geometry,
+                       hitThreshold,
+                       clocksData,
+                       calibrator,
+                       use_start_time);
+  }
 
-      const double timeStamp = waveform.TimeStamp();
+  //----------------------------------------------------------------------------
+  void RunHitFinder(std::vector<raw::OpDetWaveform> const& opDetWaveformVector,
+                    std::vector<recob::OpHit>& hitVector,
+                    std::vector<HitFinderWorker>& workers,
+                    geo::GeometryCore const& geometry,
+                    float hitThreshold,
+                    detinfo::DetectorClocksData const& clocksData,
+                    calib::IPhotonCalibrator const& calibrator,
+                    bool use_start_time)
+  {
+    RunHitFinderWorkers(opDetWaveformVector,
+                        hitVector,
+                        workers,
+                        geometry,
+                        hitThreshold,
+                        clocksData,
+                        calibrator,
+                        use_start_time);
+  }
 
-      for (auto const& pulse : pulses)
-        ConstructHit(hitThreshold,
-                     channel,
-                     timeStamp,
-                     pulse,
-                     hitVector,
-                     clocksData,
-                     calibrator,
-                     use_start_time);
-    }
+  //----------------------------------------------------------------------------
+  void RunHitFinder(std::vector<raw::OpDetWaveform const*> const& opDetWaveformPtrs,
+                    std::vector<recob::OpHit>& hitVector,
+                    std::vector<HitFinderWorker>& workers,
+                    geo::GeometryCore const& geometry,
+                    float hitThreshold,
+                    detinfo::DetectorClocksData const& clocksData,
+                    calib::IPhotonCalibrator const& calibrator,
+                    bool use_start_time)
+  {
+    RunHitFinderWorkers(opDetWaveformPtrs,
+                        hitVector,
+                        workers,
+                        geometry,
+                        hitThreshold,
+                        clocksData,
+                        calibrator,
+                        use_start_time);
   }
 
   //----------------------------------------------------------------------------
@@ -10,10 +10,13 @@
  * These are the algorithms used by OpHit to produce optical hits.
  */
 
+#include "larana/OpticalDetector/OpHitFinder/PMTPedestalBase.h"
 #include "larana/OpticalDetector/OpHitFinder/PMTPulseRecoBase.h"
+#include "larana/OpticalDetector/OpHitFinder/PulseRecoManager.h"
 #include "lardataobj/RawData/OpDetWaveform.h"
 #include "lardataobj/RecoBase/OpHit.h"
 
+#include <memory>
 #include <vector>
 
 namespace calib {
@@ -25,12 +28,34 @@ namespace detinfo {
 namespace geo {
   class GeometryCore;
 }
-namespace pmtana {
-  class PulseRecoManager;
-}
 
 namespace opdet {
 
+  /**
+   * @brief Independent set of pulse and pedestal algorithms.
+   *
+   * `pmtana::PulseRecoManager::Reconstruct()` updates the state of the
+   * algorithms it drives, so a set can serve only one waveform at a time.
+   * Each thread of `RunHitFinder()` gets its own worker; the algorithms are
+   * usually created with the `makeAlgo()` of the maker tools, which returns a
+   * new, independent instance at each call.
+   */
+  class HitFinderWorker {
+  public:
+    HitFinderWorker(std::unique_ptr<pmtana::PMTPulseRecoBase> threshAlg,
+                    std::unique_ptr<pmtana::PMTPedestalBase> pedAlg);
+
+    pmtana::PulseRecoManager const& PulseRecoMgr() const { return fPulseRecoMgr; }
+    pmtana::PulseRecoManager& PulseRecoMgr() { return fPulseRecoMgr; }
+    pmtana::PMTPulseRecoBase const& ThreshAlg() const { return *fThreshAlg; }
+    pmtana::PMTPedestalBase const& PedAlg() const { return *fPedAlg; }
+
+  private:
+    std::unique_ptr<pmtana::PMTPulseRecoBase> fThreshAlg;
+    std::unique_ptr<pmtana::PMTPedestalBase> fPedAlg;
+    pmtana::PulseRecoManager fPulseRecoMgr;
+  };
+
   void RunHitFinder(std::vector<raw::OpDetWaveform> const&,
                     std::vector<recob::OpHit>&,
                     pmtana::PulseRecoManager const&,
@@ -41,6 +66,39 @@ namespace opdet {
                     calib::IPhotonCalibrator const&,
                     bool use_start_time = false);
 
+  /// Same as above, on waveforms owned elsewhere (e.g. a selection across several
+  /// data products), which are not copied.
+  void RunHitFinder(std::vector<raw::OpDetWaveform const*> const&,
+                    std::vector<recob::OpHit>&,
+                    pmtana::PulseRecoManager const&,
+                    pmtana::PMTPulseRecoBase const&,
+                    geo::GeometryCore const&,
+                    float,
+                    detinfo::DetectorClocksData const&,
+                    calib::IPhotonCalibrator const&,
+                    bool use_start_time = false);
+
+  /// Runs the hit finding concurrently over the waveforms, one worker per thread.
+  /// Hits are stored in the order of the input waveforms, as the serial version does.
+  void RunHitFinder(std::vector<raw::OpDetWaveform> const&,
+                    std::vector<recob::OpHit>&,
+                    std::vector<HitFinderWorker>&,
+                    geo::GeometryCore const&,
+                    float,
+                    detinfo::DetectorClocksData const&,
+                    calib::IPhotonCalibrator const&,
+                    bool use_start_time = false);
+
+  /// Concurrent version on waveforms owned elsewhere.
+  void RunHitFinder(std::vector<raw::OpDetWaveform const*> const&,
+                    std::vector<recob::OpHit>&,
+                    std::vector<HitFinderWorker>&,
+                    geo::GeometryCore const&,
+                    float,
+                    detinfo::DetectorClocksData const&,
+                    calib::IPhotonCalibrator const&,
+                    bool use_start_time = false);
+
   void ConstructHit(float,
                     int,
                     double,
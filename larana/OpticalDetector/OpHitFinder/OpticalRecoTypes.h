@@ -1,13 +1,43 @@
 #ifndef larana_OPTICALDETECTOR_OPTICALRECOTYPES_H
 #define larana_OPTICALDETECTOR_OPTICALRECOTYPES_H
 
+#include <cstddef>
 #include <vector>
 
 namespace pmtana {
 
   typedef std::vector<short> Waveform_t;
-  typedef std::vector<double> PedestalMean_t;
-  typedef std::vector<double> PedestalSigma_t;
+
+  /// Storage type of the pedestal estimate of a single sample.
+  /// Single precision is plenty for ADC counts and halves the memory of double.
+  typedef float PedestalValue_t;
+  typedef std::vector<PedestalValue_t> PedestalMean_t;
+  typedef std::vector<PedestalValue_t> PedestalSigma_t;
+
+  /// Non-owning view of consecutive samples, e.g. the part of a waveform spanned by a pulse
+  template <typename T>
+  class SampleRange {
+  public:
+    SampleRange(T const* first, std::size_t size) : _first(first), _size(size) {}
+
+    /// View of the samples [start, end) of v
+    SampleRange(std::vector<T> const& v, std::size_t start, std::size_t end)
+      : SampleRange(v.data() + start, end - start)
+    {}
+
+    T const* begin() const { return _first; }
+    T const* end() const { return _first + _size; }
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    T const& operator[](std::size_t i) const { return _first[i]; }
+
+  private:
+    T const* _first;
+    std::size_t _size;
+  };
+
+  typedef SampleRange<short> WaveformRange_t;
+  typedef SampleRange<PedestalValue_t> PedestalRange_t;
 
 }
 #endif
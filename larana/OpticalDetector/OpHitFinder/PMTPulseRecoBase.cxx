@@ -94,6 +94,49 @@ namespace pmtana {
     return _pulse_v;
   }
 
+  //***************************************************************
+  void PMTPulseRecoBase::TakePulses(pulse_param_array& pulses,
+                                    size_t begin,
+                                    size_t end,
+                                    double offset)
+  //***************************************************************
+  {
+    for (auto& pulse : _pulse_v) {
+
+      if (pulse.t_start < begin || pulse.t_start >= end) continue;
+
+      pulse.t_start += offset;
+      pulse.t_max += offset;
+      pulse.t_end += offset;
+      // t_rise is relative to t_start; t_cfdcross is set by CFD only
+      if (pulse.t_cfdcross >= 0) pulse.t_cfdcross += offset;
+
+      pulses.push_back(pulse);
+    }
+    _pulse_v.clear();
+  }
+
+  //***************************************************************
+  void PMTPulseRecoBase::SetPulses(pulse_param_array&& pulses)
+  //***************************************************************
+  {
+    _pulse_v = std::move(pulses);
+  }
+
+  //***************************************************************
+  double PMTPulseRecoBase::RiseTime(const Waveform_t& wf,
+                                    const PedestalMean_t& mean_v,
+                                    size_t t_start,
+                                    size_t t_end,
+                                    bool positive)
+  //***************************************************************
+  {
+    return _risetime_calc_ptr->RiseTime(WaveformRange_t(wf, t_start, t_end),
+                                        PedestalRange_t(mean_v, t_start, t_end),
+                                        positive,
+                                        _risetime_scratch);
+  }
+
   //***************************************************************
   bool PMTPulseRecoBase::Integral(const std::vector<short>& wf,
                                   double& result,
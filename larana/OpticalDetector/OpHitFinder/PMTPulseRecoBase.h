@@ -100,6 +100,23 @@ namespace pmtana {
     /// A getter for the number of reconstructed pulses from the input waveform
     size_t GetNPulse() const { return _pulse_v.size(); };
 
+    /**
+       Moves the pulses of the last reconstruction starting in [begin, end) to the end
+       of pulses, with their times shifted by offset. Together with SetPulses(), this
+       lets PulseRecoManager merge the reconstruction of a waveform in chunks.
+    */
+    void TakePulses(pulse_param_array& pulses, size_t begin, size_t end, double offset);
+
+    /// Replaces the reconstructed pulses
+    void SetPulses(pulse_param_array&& pulses);
+
+    /**
+       Whether the algorithm finds the same pulses in a waveform reconstructed in chunks
+       (see PulseRecoManager::SetChunking()). Algorithms defining pulses by their position
+       in the whole waveform, rather than by its samples, return false.
+    */
+    virtual bool SupportsChunking() const { return true; }
+
   private:
     /// Unique name
     std::string _name;
@@ -121,6 +138,17 @@ namespace pmtana {
     /// Tool for rise time calculation
     std::unique_ptr<pmtana::RiseTimeCalculatorBase> _risetime_calc_ptr = nullptr;
 
+    /// Rise time of the samples [t_start, t_end) of a pulse, from _risetime_calc_ptr (which must be set)
+    double RiseTime(const pmtana::Waveform_t& wf,
+                    const pmtana::PedestalMean_t& mean_v,
+                    size_t t_start,
+                    size_t t_end,
+                    bool positive);
+
+  private:
+    /// Working space of the rise time calculator, reused across pulses
+    std::vector<double> _risetime_scratch;
+
   protected:
     /**
      A method to integrate an waveform from index "begin" to the "end". The result is filled in "result" reference.
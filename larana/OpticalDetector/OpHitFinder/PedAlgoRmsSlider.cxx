@@ -9,9 +9,19 @@
 #include "UtilFunc.h"
 #include "fhiclcpp/ParameterSet.h"
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <numeric>
+#include <string>
+
+namespace {
+
+  // Number of instances dumping waveforms so far: each one writes its own file,
+  // as OpHitFinder runs one instance per worker concurrently
+  std::atomic<unsigned int> NInstancesToFile{0};
+
+}
 
 namespace pmtana {
 
@@ -19,6 +29,7 @@ namespace pmtana {
   PedAlgoRmsSlider::PedAlgoRmsSlider(const std::string name) : PMTPedestalBase(name)
   //*****************************************************************
   {
+    _incremental = false;
     srand(static_cast<unsigned int>(time(0)));
   }
 
@@ -37,9 +48,14 @@ namespace pmtana {
     _num_postsample = pset.get<int>("NumPostSample", 0);
     _verbose = pset.get<bool>("Verbose", true);
     _n_wf_to_csvfile = pset.get<int>("NWaveformsToFile", 12);
+    _incremental = pset.get<bool>("Incremental", false);
 
     if (_n_wf_to_csvfile > 0) {
-      _csvfile.open("wf_pedalgormsslider.csv", std::ofstream::out | std::ofstream::trunc);
+      unsigned int const instance = NInstancesToFile++;
+      std::string const csvname =
+        (instance == 0) ? "wf_pedalgormsslider.csv" :
+                          "wf_pedalgormsslider_" + std::to_string(instance) + ".csv";
+      _csvfile.open(csvname, std::ofstream::out | std::ofstream::trunc);
       _csvfile << "n,time,wf,wf_ped_mean,wf_ped_rms" << std::endl;
     }
   }
@@ -51,11 +67,12 @@ namespace pmtana {
     std::cout << "PedAlgoRmsSlider setting:"
               << "\n\t SampleSize:       " << _sample_size
               << "\n\t Threshold:        " << _threshold << "\n\t Verbose:          " << _verbose
-              << "\n\t NWaveformsToFile: " << _n_wf_to_csvfile << std::endl;
+              << "\n\t NWaveformsToFile: " << _n_wf_to_csvfile
+              << "\n\t Incremental:      " << _incremental << std::endl;
   }
 
   //****************************************************************************
-  double PedAlgoRmsSlider::CalcMean(const std::vector<double>& wf, size_t start, size_t nsample)
+  double PedAlgoRmsSlider::CalcMean(const pmtana::PedestalMean_t& wf, size_t start, size_t nsample)
   //****************************************************************************
   {
     if (!nsample) nsample = wf.size();
@@ -70,7 +87,7 @@ namespace pmtana {
   }
 
   //****************************************************************************
-  double PedAlgoRmsSlider::CalcStd(const std::vector<double>& wf,
+  double PedAlgoRmsSlider::CalcStd(const pmtana::PedestalMean_t& wf,
                                    const double ped_mean,
                                    size_t start,
                                    size_t nsample)
@@ -91,6 +108,61 @@ namespace pmtana {
     return sigma;
   }
 
+  //****************************************************************************
+  void PedAlgoRmsSlider::LocalStats(const pmtana::Waveform_t& wf,
+                                    size_t i,
+                                    double& local_mean,
+                                    double& local_rms)
+  //****************************************************************************
+  {
+    if (_incremental) {
+      local_mean = _window_stats.Mean(i, _sample_size);
+      local_rms = _window_stats.Sigma(i, _sample_size);
+    }
+    else {
+      local_mean = mean(wf, i, _sample_size);
+      local_rms = std(wf, local_mean, i, _sample_size);
+    }
+  }
+
+  //****************************************************************************
+  void PedAlgoRmsSlider::SmoothIncremental(const pmtana::PedestalMean_t& mean_temp_v,
+                                           const std::vector<bool>& ped_interpolated,
+                                           pmtana::PedestalMean_t& mean_v,
+                                           pmtana::PedestalSigma_t& sigma_v)
+  //****************************************************************************
+  {
+    const size_t window_size = _sample_size * 2;
+    const size_t n = mean_temp_v.size();
+
+    // sums are taken relative to the first sample to keep the squares small:
+    // where mean_temp_v still holds raw ADC counts the sums stay exact
+    const double ref = mean_temp_v.front();
+    double sum = 0, sum2 = 0;
+    for (size_t k = 0; k < window_size; ++k) {
+      const double d = mean_temp_v[k] - ref;
+      sum += d;
+      sum2 += d * d;
+    }
+
+    for (size_t i = _sample_size; i < n - _sample_size; ++i) {
+
+      if (i > _sample_size) {
+        const double d_in = mean_temp_v[i + _sample_size - 1] - ref;
+        const double d_out = mean_temp_v[i - _sample_size - 1] - ref;
+        sum += d_in - d_out;
+        sum2 += d_in * d_in - d_out * d_out;
+      }
+
+      const double m = sum / window_size;
+      mean_v[i] = ref + m;
+      if (!ped_interpolated[i]) {
+        const double var = sum2 / window_size - m * m;
+        sigma_v[i] = var > 0 ? sqrt(var) : 0.;
+      }
+    }
+  }
+
   //****************************************************************************
   bool PedAlgoRmsSlider::ComputePedestal(const pmtana::Waveform_t& wf,
                                          pmtana::PedestalMean_t& mean_v,
@@ -128,10 +200,11 @@ namespace pmtana {
     std::vector<double> local_mean_v(wf.size(), -1.);
     std::vector<double> local_sigma_v(wf.size(), -1.);
 
+    if (_incremental) _window_stats.Fill(wf);
+
     for (size_t i = 0; i < wf.size() - _sample_size; i++) {
 
-      local_mean = mean(wf, i, _sample_size);
-      local_rms = std(wf, local_mean, i, _sample_size);
+      LocalStats(wf, i, local_mean, local_rms);
 
       if (_verbose)
         std::cout << "\033[93mPedAlgoRmsSlider\033[00m: i " << i << "  local_mean: " << local_mean
@@ -265,15 +338,13 @@ namespace pmtana {
 
     bool end_found = false;
 
-    local_mean = mean(wf, 0, _sample_size);
-    local_rms = std(wf, local_mean, 0, _sample_size);
+    LocalStats(wf, 0, local_mean, local_rms);
 
     if (local_rms >= _threshold) {
 
       for (size_t i = 1; i < wf.size() - _sample_size; i++) {
 
-        local_mean = mean(wf, i, _sample_size);
-        local_rms = std(wf, local_mean, i, _sample_size);
+        LocalStats(wf, i, local_mean, local_rms);
 
         if (local_rms < _threshold) {
 
@@ -301,15 +372,13 @@ namespace pmtana {
 
     bool start_found = false;
 
-    local_mean = mean(wf, wf.size() - 1 - _sample_size, _sample_size);
-    local_rms = std(wf, local_mean, wf.size() - 1 - _sample_size, _sample_size);
+    LocalStats(wf, wf.size() - 1 - _sample_size, local_mean, local_rms);
 
     if (local_rms >= _threshold) {
 
       size_t i = wf.size() - 1 - _sample_size;
       while (i-- > 0) {
-        local_mean = mean(wf, i, _sample_size);
-        local_rms = std(wf, local_mean, i, _sample_size);
+        LocalStats(wf, i, local_mean, local_rms);
 
         if (local_rms < _threshold) {
 
@@ -340,13 +409,17 @@ namespace pmtana {
     const size_t window_size = _sample_size * 2;
 
     // middle mean
-    for (size_t i = 0; i < mean_temp_v.size(); ++i) {
+    if (_incremental)
+      SmoothIncremental(mean_temp_v, ped_interapolated, mean_v, sigma_v);
+    else {
+      for (size_t i = 0; i < mean_temp_v.size(); ++i) {
 
-      if (i < _sample_size || i >= (wf.size() - _sample_size)) continue;
+        if (i < _sample_size || i >= (wf.size() - _sample_size)) continue;
 
-      mean_v[i] = this->CalcMean(mean_temp_v, i - _sample_size, window_size);
-      if (!ped_interapolated[i]) {
-        sigma_v[i] = this->CalcStd(mean_temp_v, mean_v[i], i - _sample_size, window_size);
+        mean_v[i] = this->CalcMean(mean_temp_v, i - _sample_size, window_size);
+        if (!ped_interapolated[i]) {
+          sigma_v[i] = this->CalcStd(mean_temp_v, mean_v[i], i - _sample_size, window_size);
+        }
       }
     }
 
@@ -18,6 +18,7 @@
 #include "larana/OpticalDetector/OpHitFinder/OpticalRecoTypes.h"
 
 #include "PMTPedestalBase.h"
+#include "UtilFunc.h"
 namespace fhicl {
   class ParameterSet;
 }
@@ -63,17 +64,30 @@ namespace pmtana {
     int _wf_saved = 0;
     int _num_presample;  ///< number of ADCs to sample before the gap
     int _num_postsample; ///< number of ADCs to sample after the gap
+    bool _incremental;   ///< Use running sums for the sliding statistics (O(N) per waveform)
     std::ofstream _csvfile;
 
+    /// Running sums of the current waveform, used when _incremental is set
+    WindowStats _window_stats;
+
     /// Returns the mean of the elements of the vector from start to start+nsample
-    double CalcMean(const std::vector<double>& wf, size_t start, size_t nsample);
+    double CalcMean(const pmtana::PedestalMean_t& wf, size_t start, size_t nsample);
 
     /// Returns the std of the elements of the vector from start to start+nsample
-    double CalcStd(const std::vector<double>& wf,
+    double CalcStd(const pmtana::PedestalMean_t& wf,
                    const double ped_mean,
                    size_t start,
                    size_t nsample);
 
+    /// Computes mean and rms of the _sample_size samples of wf starting at index i
+    void LocalStats(const pmtana::Waveform_t& wf, size_t i, double& local_mean, double& local_rms);
+
+    /// Smooths mean_temp_v over 2*_sample_size samples, adding and dropping one sample per step
+    void SmoothIncremental(const pmtana::PedestalMean_t& mean_temp_v,
+                           const std::vector<bool>& ped_interpolated,
+                           pmtana::PedestalMean_t& mean_v,
+                           pmtana::PedestalSigma_t& sigma_v);
+
     /// Checks the sanity of the estimated pedestal, returns false if not sane
     bool CheckSanity(pmtana::PedestalMean_t& mean_v, pmtana::PedestalSigma_t& sigma_v);
   };
@@ -58,6 +58,8 @@ namespace pmtana {
 
     const size_t window_size = _sample_size * 2;
 
+    _window_stats.Fill(wf);
+
     // middle mean
     for (size_t i = 0; i < wf.size(); ++i) {
 
@@ -66,8 +68,8 @@ namespace pmtana {
 
       if (i < _sample_size || i >= (wf.size() - _sample_size)) continue;
 
-      mean_v[i] = mean(wf, i - _sample_size, window_size);
-      sigma_v[i] = std(wf, mean_v[i], i - _sample_size, window_size);
+      mean_v[i] = _window_stats.Mean(i - _sample_size, window_size);
+      sigma_v[i] = _window_stats.Sigma(i - _sample_size, window_size);
     }
 
     // front mean
@@ -122,9 +124,10 @@ namespace pmtana {
 
     unsigned nbins = 1000;
 
-    //////////////////seg faulting...
-    const auto mode_mean = BinnedMaxOccurrence(mean_v, nbins);
-    const auto mode_sigma = BinnedMaxOccurrence(sigma_v, nbins);
+    // each mean is the sum of window_size ADC counts divided by window_size:
+    // its mode is found exactly by counting; sigma has no such structure
+    const auto mode_mean = _mode_finder.MaxOccurrence(mean_v, window_size);
+    const auto mode_sigma = _mode_finder.BinnedMaxOccurrence(sigma_v, nbins);
 
     //auto mode_mean  = BinnedMaxTH1D(mean_v ,nbins);
     //auto mode_sigma = BinnedMaxTH1D(sigma_v,nbins);
@@ -16,6 +16,7 @@
 #define larana_OPTICALDETECTOR_PEDALGOROLLINGMEAN_H
 
 #include "PMTPedestalBase.h"
+#include "UtilFunc.h"
 namespace fhicl {
   class ParameterSet;
 }
@@ -60,6 +61,12 @@ namespace pmtana {
 
     int _n_presamples;
 
+    /// Running sums of the current waveform, for constant-time window statistics
+    WindowStats _window_stats;
+
+    /// Mode estimator of pedestal mean and sigma, with its own counting buffer
+    ModeFinder _mode_finder;
+
     //double _random_shift;
   };
 }
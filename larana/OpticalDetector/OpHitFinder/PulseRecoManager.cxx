@@ -9,12 +9,13 @@
 #include "larana/OpticalDetector/OpHitFinder/PMTPedestalBase.h"
 #include "larana/OpticalDetector/OpHitFinder/PMTPulseRecoBase.h"
 
+#include <algorithm>
 #include <sstream>
 
 namespace pmtana {
 
   //*******************************************************
-  PulseRecoManager::PulseRecoManager() : _ped_algo(nullptr)
+  PulseRecoManager::PulseRecoManager() : _ped_algo(nullptr), _chunk_size(0), _chunk_overlap(0)
   //*******************************************************
   {
     _reco_algo_v.clear();
@@ -26,6 +27,10 @@ namespace pmtana {
   {
     if (!algo) throw OpticalRecoException("Invalid PulseReco algorithm!");
 
+    if (_chunk_size && !algo->SupportsChunking())
+      throw OpticalRecoException("PulseReco algorithm " + algo->Name() +
+                                 " does not support reconstruction in chunks!");
+
     _reco_algo_v.push_back(std::make_pair(algo, ped_algo));
   }
 
@@ -37,6 +42,26 @@ namespace pmtana {
     _ped_algo = algo;
   }
 
+  //****************************************************************************
+  void PulseRecoManager::SetChunking(size_t chunk_size, size_t overlap)
+  //****************************************************************************
+  {
+    if (chunk_size) {
+      if (!overlap)
+        throw OpticalRecoException(
+          "Reconstruction in chunks needs an overlap: pulses across chunk boundaries would be cut!");
+
+      for (auto const& reco_algo : _reco_algo_v) {
+        if (!reco_algo.first->SupportsChunking())
+          throw OpticalRecoException("PulseReco algorithm " + reco_algo.first->Name() +
+                                     " does not support reconstruction in chunks!");
+      }
+    }
+
+    _chunk_size = chunk_size;
+    _chunk_overlap = overlap;
+  }
+
   //**********************************************************************
   bool PulseRecoManager::Reconstruct(const pmtana::Waveform_t& wf) const
   //**********************************************************************
@@ -45,6 +70,103 @@ namespace pmtana {
 
       throw OpticalRecoException("No Pulse/Pedestal reconstruction to run!");
 
+    if (_chunk_size && wf.size() >= 2 * _chunk_size) return ReconstructChunks(wf);
+
+    return ReconstructWaveform(wf);
+  }
+
+  //******************************************************************************
+  bool PulseRecoManager::ReconstructChunks(const pmtana::Waveform_t& wf) const
+  //******************************************************************************
+  {
+    // The pedestal algorithms look at the whole waveform (its edges, the most frequent
+    // mean...): a chunk of it would give them a different pedestal. They run once on all
+    // of wf, and each chunk is given the matching range of its pedestal.
+    bool ped_status = true;
+
+    if (_ped_algo) ped_status = _ped_algo->Evaluate(wf);
+
+    const bool default_ped_status = ped_status;
+
+    // pedestal of each pulse algorithm, and whether it (and those before) succeeded
+    std::vector<std::pair<const PMTPedestalBase*, bool>> ped_v;
+    ped_v.reserve(_reco_algo_v.size());
+
+    for (auto const& algo_pair : _reco_algo_v) {
+
+      auto const& ped_algo = algo_pair.second;
+
+      if (ped_algo) {
+        ped_status = ped_status && ped_algo->Evaluate(wf);
+        ped_v.emplace_back(ped_algo, ped_status);
+      }
+      else {
+
+        if (!_ped_algo) {
+          std::stringstream ss;
+          ss << "No pedestal algorithm available for pulse algo " << algo_pair.first->Name();
+          throw OpticalRecoException(ss.str());
+        }
+
+        ped_v.emplace_back(_ped_algo, true);
+      }
+    }
+
+    bool status = true;
+
+    // pulses of the whole waveform, per algorithm
+    std::vector<pulse_param_array> pulses_v(_reco_algo_v.size());
+
+    Waveform_t chunk;
+    PedestalMean_t mean_chunk;
+    PedestalSigma_t sigma_chunk;
+
+    size_t own_end = 0;
+    for (size_t own_begin = 0; own_begin < wf.size(); own_begin = own_end) {
+
+      // a last chunk shorter than chunk_size is merged into the one before
+      own_end = (wf.size() - own_begin < 2 * _chunk_size) ? wf.size() : own_begin + _chunk_size;
+      const size_t begin = own_begin > _chunk_overlap ? own_begin - _chunk_overlap : 0;
+      const size_t end = std::min(own_end + _chunk_overlap, wf.size());
+
+      chunk.assign(wf.begin() + begin, wf.begin() + end);
+
+      bool chunk_status = default_ped_status;
+
+      for (size_t i = 0; i < _reco_algo_v.size(); ++i) {
+
+        auto& pulse_algo = _reco_algo_v[i].first;
+
+        // an algorithm skipped after a failure must not keep the previous chunk's pulses
+        pulse_algo->Reset();
+
+        if (ped_v[i].second && chunk_status) {
+          auto const& mean_v = ped_v[i].first->Mean();
+          auto const& sigma_v = ped_v[i].first->Sigma();
+          mean_chunk.assign(mean_v.begin() + begin, mean_v.begin() + end);
+          sigma_chunk.assign(sigma_v.begin() + begin, sigma_v.begin() + end);
+
+          chunk_status = pulse_algo->Reconstruct(chunk, mean_chunk, sigma_chunk);
+        }
+        else
+          chunk_status = false;
+
+        pulse_algo->TakePulses(pulses_v[i], own_begin - begin, own_end - begin, begin);
+      }
+
+      status = status && chunk_status;
+    }
+
+    for (size_t i = 0; i < _reco_algo_v.size(); ++i)
+      _reco_algo_v[i].first->SetPulses(std::move(pulses_v[i]));
+
+    return status;
+  }
+
+  //********************************************************************************
+  bool PulseRecoManager::ReconstructWaveform(const pmtana::Waveform_t& wf) const
+  //********************************************************************************
+  {
     bool ped_status = true;
 
     if (_ped_algo) ped_status = _ped_algo->Evaluate(wf);
@@ -36,7 +36,11 @@ namespace pmtana {
     /// Default constructor
     PulseRecoManager();
 
-    /// Implementation of ana_base::analyze method
+    /**
+       Implementation of ana_base::analyze method.
+       Note that this updates the state of the registered algorithms: the same
+       manager (or algorithms) must not be used by more than one thread at a time.
+    */
     bool Reconstruct(const pmtana::Waveform_t&) const;
 
     /// A method to set pulse reconstruction algorithm
@@ -45,12 +49,43 @@ namespace pmtana {
     /// A method to set a choice of pedestal estimation method
     void SetDefaultPedAlgo(pmtana::PMTPedestalBase* algo);
 
+    /**
+       Sets the reconstruction of waveforms of at least 2 * chunk_size samples to proceed
+       in chunks of chunk_size samples (0, the default, reconstructs the whole waveform at
+       once); a shorter remainder is added to the last chunk. Each chunk is extended by
+       overlap samples on both sides, and keeps the pulses starting within its own
+       samples: a pulse across a chunk boundary is found whole by the chunk where it
+       starts, provided overlap is longer than the pulse and than the range of samples
+       the algorithms look at around it. A zero overlap is rejected with chunk_size.
+       Pulse algorithms then only work on chunk_size + 2 * overlap samples at a time,
+       whatever the waveform length. The pedestal algorithms depend on the whole waveform
+       (its edges, its most frequent value...), so they still run once on all of it and
+       their memory is not bounded; each chunk gets the matching range of the pedestal.
+       After Reconstruct() the pulse algorithms hold the pulses of the whole waveform
+       (in waveform ticks), and the pedestal algorithms the pedestal of the whole waveform.
+       Pulse algorithms whose pulses are set by their position in the waveform, like
+       AlgoFixedWindow, cannot run in chunks: an exception is thrown if they are added.
+    */
+    void SetChunking(size_t chunk_size, size_t overlap);
+
   private:
+    /// Runs the pedestal and pulse algorithms on the whole of wf
+    bool ReconstructWaveform(const pmtana::Waveform_t& wf) const;
+
+    /// Runs the pedestal and pulse algorithms chunk by chunk
+    bool ReconstructChunks(const pmtana::Waveform_t& wf) const;
+
     /// pulse reconstruction algorithm pointer
     std::vector<std::pair<pmtana::PMTPulseRecoBase*, pmtana::PMTPedestalBase*>> _reco_algo_v;
 
     /// ped_estimator object
     PMTPedestalBase* _ped_algo;
+
+    /// Number of samples reconstructed at a time (0: the whole waveform)
+    size_t _chunk_size;
+
+    /// Extra samples added to each chunk on both sides
+    size_t _chunk_overlap;
   };
 }
 #endif
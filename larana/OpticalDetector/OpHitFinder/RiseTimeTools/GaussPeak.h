@@ -0,0 +1,97 @@
+/**
+ * \file GaussPeak.h
+ *
+ * \brief Helpers to locate the first peak of a pedestal-subtracted pulse,
+ * shared by the rise time tools
+ *
+ */
+
+#ifndef GAUSSPEAK_H
+#define GAUSSPEAK_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace pmtana {
+
+  /**
+   Position of the first local maximum of arr at or above threshold.
+   Linear search, O(N): the first peak should be close to the start of the
+   vector for scintillation LAr signals. Returns arr.size() if there is none.
+  */
+  inline std::size_t FindFirstMax(const std::vector<double>& arr, double threshold)
+  {
+    if (arr.empty()) return 0;
+    double max = arr[0];
+    for (std::size_t i = 1, n = arr.size(); i < n; ++i) {
+      if (arr[i] >= max)
+        max = arr[i];
+
+      else if (max < threshold) //didn't pass the threshold, keep searching
+        max = arr[i];
+
+      else
+        return i - 1;
+    }
+    return arr.size();
+  }
+
+  /**
+   Centre of the Gaussian through the samples of arr around i_max, in ticks.
+   The logarithm of a Gaussian is a parabola: a parabola is fitted to the log of
+   the (2*half_width+1) samples centred on i_max, weighted by the squared sample
+   value to keep the noisier low samples from dominating, and its vertex returned.
+   With half_width 1 this is the exact three-point interpolation.
+   Samples outside arr or not positive are skipped; i_max is returned when fewer
+   than three are left or the fitted parabola has no maximum within the samples.
+  */
+  inline double LogParabolaPeak(const std::vector<double>& arr,
+                                std::size_t i_max,
+                                std::size_t half_width)
+  {
+    // weighted sums of x^k and x^k log(y), with x relative to i_max
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0, s4 = 0;
+    double t0 = 0, t1 = 0, t2 = 0;
+    std::size_t n_used = 0;
+
+    // logs are taken relative to the maximum, which keeps the sums small
+    if (i_max >= arr.size() || arr[i_max] <= 0) return i_max;
+    const double log_max = std::log(arr[i_max]);
+
+    const std::size_t first = i_max > half_width ? i_max - half_width : 0;
+    const std::size_t last = std::min(i_max + half_width + 1, arr.size());
+    for (std::size_t i = first; i < last; ++i) {
+      if (arr[i] <= 0) continue;
+      const double x = double(i) - double(i_max);
+      const double w = arr[i] * arr[i];
+      const double l = std::log(arr[i]) - log_max;
+      s0 += w;
+      s1 += w * x;
+      s2 += w * x * x;
+      s3 += w * x * x * x;
+      s4 += w * x * x * x * x;
+      t0 += w * l;
+      t1 += w * x * l;
+      t2 += w * x * x * l;
+      ++n_used;
+    }
+    if (n_used < 3) return i_max;
+
+    // normal equations of log(y) = a + b x + c x^2, solved for b and c (Cramer's rule)
+    const double det = s0 * (s2 * s4 - s3 * s3) - s1 * (s1 * s4 - s2 * s3) + s2 * (s1 * s3 - s2 * s2);
+    if (det == 0) return i_max;
+    const double b = (s0 * (t1 * s4 - s3 * t2) - t0 * (s1 * s4 - s2 * s3) + s2 * (s1 * t2 - t1 * s2)) / det;
+    const double c = (s0 * (s2 * t2 - t1 * s3) - s1 * (s1 * t2 - t1 * s2) + t0 * (s1 * s3 - s2 * s2)) / det;
+    if (c >= 0) return i_max;
+
+    const double offset = -b / (2 * c);
+    if (std::abs(offset) > double(half_width)) return i_max;
+
+    return i_max + offset;
+  }
+
+}
+
+#endif
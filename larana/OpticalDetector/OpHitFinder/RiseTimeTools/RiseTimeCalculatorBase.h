@@ -12,6 +12,8 @@
 
 #include "larana/OpticalDetector/OpHitFinder/OpticalRecoTypes.h"
 
+#include <vector>
+
 namespace pmtana {
   class RiseTimeCalculatorBase {
 
@@ -19,12 +21,36 @@ namespace pmtana {
     // Default destructor
     virtual ~RiseTimeCalculatorBase() noexcept = default;
 
-    // Method to calculate the OpFlash t0
-    virtual double RiseTime(const pmtana::Waveform_t& wf_pulse,
-                            const pmtana::PedestalMean_t& ped_pulse,
-                            bool _positive) const = 0;
+    /**
+     Method to calculate the rise time, in ticks from the first sample of the pulse.
+     wf_pulse and ped_pulse view the same samples of the waveform and of its pedestal.
+     scratch is a buffer owned by the caller that the tool may use as working space,
+     so that its memory is reused from one pulse to the next.
+    */
+    virtual double RiseTime(pmtana::WaveformRange_t wf_pulse,
+                            pmtana::PedestalRange_t ped_pulse,
+                            bool _positive,
+                            std::vector<double>& scratch) const = 0;
 
-  private:
+  protected:
+    /// Fills pulse with the pedestal-subtracted samples, positive for either polarity
+    static void SubtractPedestal(pmtana::WaveformRange_t wf_pulse,
+                                 pmtana::PedestalRange_t ped_pulse,
+                                 bool _positive,
+                                 std::vector<double>& pulse)
+    {
+      pulse.resize(wf_pulse.size());
+      if (_positive) {
+        for (size_t ix = 0; ix < pulse.size(); ix++) {
+          pulse[ix] = ((double)wf_pulse[ix]) - ped_pulse[ix];
+        }
+      }
+      else {
+        for (size_t ix = 0; ix < pulse.size(); ix++) {
+          pulse[ix] = ped_pulse[ix] - ((double)wf_pulse[ix]);
+        }
+      }
+    }
   };
 }
 
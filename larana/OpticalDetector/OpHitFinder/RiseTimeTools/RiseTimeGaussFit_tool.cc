@@ -13,12 +13,25 @@
 #include "fhiclcpp/types/Atom.h"
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
+#include "GaussPeak.h"
 #include "RiseTimeCalculatorBase.h"
 
 // ROOT includes
 #include "TF1.h"
 #include "TH1F.h"
 
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace {
+
+  // Number of tool instances so far, which keeps the names of their ROOT
+  // objects apart (OpHitFinder runs one instance per worker concurrently)
+  std::atomic<unsigned int> NInstances{0};
+
+}
+
 namespace pmtana {
 
   class RiseTimeGaussFit : RiseTimeCalculatorBase {
@@ -37,9 +50,10 @@ namespace pmtana {
     explicit RiseTimeGaussFit(art::ToolConfigTable<Config> const& config);
 
     // Method to calculate the OpFlash t0
-    double RiseTime(const pmtana::Waveform_t& wf_pulse,
-                    const pmtana::PedestalMean_t& ped_pulse,
-                    bool _positive) const override;
+    double RiseTime(pmtana::WaveformRange_t wf_pulse,
+                    pmtana::PedestalRange_t ped_pulse,
+                    bool _positive,
+                    std::vector<double>& scratch) const override;
     // Method to fit the first local max of the wvf above fixed threshold
     std::size_t findFirstMax(const std::vector<double>& arr, double threshold) const;
 
@@ -48,6 +62,13 @@ namespace pmtana {
     double fInitSigma;
     double fTolerance;
     int fNbins;
+    std::string fNameSuffix; // Unique to this instance, for the names of its ROOT objects
+
+    // Histogram and function of the fit, created once and reused for every pulse.
+    // The histogram spans the fit range only, centred on the first maximum.
+    // A tool instance thus serves one pulse at a time: each algorithm owns its own.
+    std::unique_ptr<TH1F> fHist;
+    std::unique_ptr<TF1> fGaus;
   };
 
   RiseTimeGaussFit::RiseTimeGaussFit(art::ToolConfigTable<Config> const& config)
@@ -55,40 +76,49 @@ namespace pmtana {
     , fInitSigma{config().InitSigma()}
     , fTolerance{config().Tolerance()}
     , fNbins{config().Nbins()}
-  {}
+    , fNameSuffix{std::to_string(NInstances++)}
+    , fHist{std::make_unique<TH1F>(("RiseTimeGaussFit_aux_" + fNameSuffix).c_str(),
+                                   "aux",
+                                   2 * fNbins + 1,
+                                   -fNbins - 0.5,
+                                   fNbins + 0.5)}
+    , fGaus{std::make_unique<TF1>(("RiseTimeGaussFit_gaus_" + fNameSuffix).c_str(),
+                                  "gaus",
+                                  -fNbins,
+                                  fNbins,
+                                  TF1::EAddToList::kNo)}
+  {
+    // owned here, not by the current ROOT directory
+    fHist->SetDirectory(nullptr);
+  }
 
-  double RiseTimeGaussFit::RiseTime(const pmtana::Waveform_t& wf_pulse,
-                                    const pmtana::PedestalMean_t& ped_pulse,
-                                    bool _positive) const
+  double RiseTimeGaussFit::RiseTime(pmtana::WaveformRange_t wf_pulse,
+                                    pmtana::PedestalRange_t ped_pulse,
+                                    bool _positive,
+                                    std::vector<double>& scratch) const
   {
 
     // Pedestal-subtracted pulse
-    std::vector<double> wf_aux(ped_pulse);
-    if (_positive) {
-      for (size_t ix = 0; ix < wf_aux.size(); ix++) {
-        wf_aux[ix] = ((double)wf_pulse[ix]) - wf_aux[ix];
-      }
-    }
-    else {
-      for (size_t ix = 0; ix < wf_aux.size(); ix++) {
-        wf_aux[ix] = wf_aux[ix] - ((double)wf_pulse[ix]);
-      }
-    }
+    std::vector<double>& wf_aux = scratch;
+    SubtractPedestal(wf_pulse, ped_pulse, _positive, wf_aux);
 
     // Find first local maximum
     size_t first_max = findFirstMax(wf_aux, fMinAmp);
 
-    // Create & fill th1
-    TH1F* h_aux = new TH1F("aux", "aux", wf_aux.size(), -0.5, wf_aux.size() - 0.5);
-    for (long unsigned int j = 0; j < wf_aux.size(); j++)
-      h_aux->SetBinContent(j + 1, wf_aux[j]);
-
-    // Function & initial values for the fit, ROOT Gaussian:  [p0]*e**(-0.5 (x-[p1])**2 / [p2]**2)
-    TF1* f = new TF1("f", "gaus", double(first_max) - fNbins, double(first_max) + fNbins);
-    f->SetParameters(wf_aux[first_max], first_max, fInitSigma);
-    // Fit
-    h_aux->Fit(f, "q", "SAME", first_max - fNbins, first_max + fNbins);
-    double t_fit = f->GetParameter(1);
+    // Fill the histogram with the samples around the maximum; samples beyond the
+    // pulse are left empty, and empty bins do not enter the fit
+    const int n_samples = wf_aux.size();
+    for (int j = -fNbins; j <= fNbins; j++) {
+      const int ix = int(first_max) + j;
+      fHist->SetBinContent(j + fNbins + 1, (ix >= 0 && ix < n_samples) ? wf_aux[ix] : 0.);
+    }
+
+    // Initial values for the fit, ROOT Gaussian:  [p0]*e**(-0.5 (x-[p1])**2 / [p2]**2),
+    // with x relative to the first maximum
+    fGaus->SetParameters(wf_aux[first_max], 0., fInitSigma);
+    // Fit; "N" keeps the histogram from storing a copy of the function
+    fHist->Fit(fGaus.get(), "qN", "", -fNbins, fNbins);
+    double t_fit = first_max + fGaus->GetParameter(1);
     double peak_time;
     if (
       std::abs(t_fit - first_max) <
@@ -104,21 +134,9 @@ namespace pmtana {
   }
 
   std::size_t RiseTimeGaussFit::findFirstMax(const std::vector<double>& arr, double threshold) const
-  { /**
-    * Linear search, O(N), 1st peak should be close to the start of the vector
-    * for scintillation LAr Signals. Returns the position of the first local max
-    **/
-    double max = arr[0];
-    for (std::size_t i = 1, n = arr.size(); i < n; ++i) {
-      if (arr[i] >= max)
-        max = arr[i];
-
-      else if (max < threshold) //didn't pass the threshold, keep searching
-        max = arr[i];
-
-      else
-        return i - 1;
-    }
+  {
+    std::size_t first_max = FindFirstMax(arr, threshold);
+    if (first_max < arr.size()) return first_max;
 
     //No local maxima found.
     mf::LogInfo("RiseTimeGaussFit") << "No local max found above fixed threshold: " << threshold;
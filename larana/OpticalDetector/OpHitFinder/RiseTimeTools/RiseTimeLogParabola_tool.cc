@@ -0,0 +1,72 @@
+/**
+ * \file RiseTimeLogParabola_tool.cc
+ *
+ * \brief Rise time as the centre of the first local maximum, like
+ * RiseTimeGaussFit, but with the Gaussian centre obtained in closed form
+ * from a parabola through the logarithm of the samples around the maximum
+ * instead of a ROOT fit. Fixed min threshold required set in the fhicl file
+ *
+ */
+
+#include "art/Utilities/ToolConfigTable.h"
+#include "art/Utilities/ToolMacros.h"
+#include "fhiclcpp/types/Atom.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "GaussPeak.h"
+#include "RiseTimeCalculatorBase.h"
+
+namespace pmtana {
+
+  class RiseTimeLogParabola : RiseTimeCalculatorBase {
+
+  public:
+    //Configuration parameters
+    struct Config {
+
+      fhicl::Atom<double> MinAmp{fhicl::Name("MinAmp")};
+      fhicl::Atom<unsigned int> HalfWidth{fhicl::Name("HalfWidth")};
+    };
+
+    // Default constructor
+    explicit RiseTimeLogParabola(art::ToolConfigTable<Config> const& config);
+
+    // Method to calculate the OpFlash t0
+    double RiseTime(pmtana::WaveformRange_t wf_pulse,
+                    pmtana::PedestalRange_t ped_pulse,
+                    bool _positive,
+                    std::vector<double>& scratch) const override;
+
+  private:
+    double fMinAmp;
+    unsigned int fHalfWidth;
+  };
+
+  RiseTimeLogParabola::RiseTimeLogParabola(art::ToolConfigTable<Config> const& config)
+    : fMinAmp{config().MinAmp()}, fHalfWidth{config().HalfWidth()}
+  {}
+
+  double RiseTimeLogParabola::RiseTime(pmtana::WaveformRange_t wf_pulse,
+                                       pmtana::PedestalRange_t ped_pulse,
+                                       bool _positive,
+                                       std::vector<double>& scratch) const
+  {
+
+    // Pedestal-subtracted pulse
+    std::vector<double>& wf_aux = scratch;
+    SubtractPedestal(wf_pulse, ped_pulse, _positive, wf_aux);
+
+    // Find first local maximum
+    std::size_t first_max = FindFirstMax(wf_aux, fMinAmp);
+    if (first_max >= wf_aux.size()) {
+      mf::LogInfo("RiseTimeLogParabola")
+        << "No local max found above fixed threshold: " << fMinAmp;
+      return 0;
+    }
+
+    return LogParabolaPeak(wf_aux, first_max, fHalfWidth);
+  }
+
+}
+
+DEFINE_ART_CLASS_TOOL(pmtana::RiseTimeLogParabola)
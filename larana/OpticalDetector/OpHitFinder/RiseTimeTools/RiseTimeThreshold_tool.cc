@@ -14,6 +14,8 @@
 
 #include "RiseTimeCalculatorBase.h"
 
+#include <algorithm>
+
 namespace pmtana {
 
   class RiseTimeThreshold : RiseTimeCalculatorBase {
@@ -29,9 +31,10 @@ namespace pmtana {
     explicit RiseTimeThreshold(art::ToolConfigTable<Config> const& config);
 
     // Method to calculate the OpFlash t0
-    double RiseTime(const pmtana::Waveform_t& wf_pulse,
-                    const pmtana::PedestalMean_t& ped_pulse,
-                    bool _positive) const override;
+    double RiseTime(pmtana::WaveformRange_t wf_pulse,
+                    pmtana::PedestalRange_t ped_pulse,
+                    bool _positive,
+                    std::vector<double>& scratch) const override;
 
   private:
     double fPeakRatio;
@@ -41,23 +44,15 @@ namespace pmtana {
     : fPeakRatio{config().PeakRatio()}
   {}
 
-  double RiseTimeThreshold::RiseTime(const pmtana::Waveform_t& wf_pulse,
-                                     const pmtana::PedestalMean_t& ped_pulse,
-                                     bool _positive) const
+  double RiseTimeThreshold::RiseTime(pmtana::WaveformRange_t wf_pulse,
+                                     pmtana::PedestalRange_t ped_pulse,
+                                     bool _positive,
+                                     std::vector<double>& scratch) const
   {
 
     // Pedestal-subtracted pulse
-    std::vector<double> wf_aux(ped_pulse);
-    if (_positive) {
-      for (size_t ix = 0; ix < wf_aux.size(); ix++) {
-        wf_aux[ix] = ((double)wf_pulse[ix]) - wf_aux[ix];
-      }
-    }
-    else {
-      for (size_t ix = 0; ix < wf_aux.size(); ix++) {
-        wf_aux[ix] = wf_aux[ix] - ((double)wf_pulse[ix]);
-      }
-    }
+    std::vector<double>& wf_aux = scratch;
+    SubtractPedestal(wf_pulse, ped_pulse, _positive, wf_aux);
 
     auto it_max = max_element(wf_aux.begin(), wf_aux.end());
     size_t rise = std::lower_bound(wf_aux.begin(), it_max, fPeakRatio * (*it_max)) - wf_aux.begin();
@@ -58,41 +58,131 @@ namespace pmtana {
   }
 
   double BinnedMaxOccurrence(const PedestalMean_t& mean_v, const size_t nbins)
+  {
+    ModeFinder finder;
+    return finder.BinnedMaxOccurrence(mean_v, nbins);
+  }
+
+  // template<typename W>
+  int sign(double val)
+  {
+
+    if (val > 0) return 1;
+    if (val < 0) return -1;
+    return 0;
+  }
+
+  //****************************************************
+  void WindowStats::Fill(const std::vector<short>& wf)
+  //****************************************************
+  {
+    _sum_v.resize(wf.size() + 1);
+    _sum2_v.resize(wf.size() + 1);
+
+    _sum_v[0] = _sum2_v[0] = 0;
+    for (size_t i = 0; i < wf.size(); ++i) {
+      const int64_t v = wf[i];
+      _sum_v[i + 1] = _sum_v[i] + v;
+      _sum2_v[i + 1] = _sum2_v[i] + v * v;
+    }
+  }
+
+  //*****************************************************************
+  void WindowStats::CheckRange(size_t start, size_t& nsample) const
+  //*****************************************************************
+  {
+    if (!nsample) nsample = Size();
+    if (start > Size() || (start + nsample) > Size())
+      throw OpticalRecoException("Invalid start/end index!");
+  }
+
+  //******************************************************************
+  double WindowStats::Mean(size_t start, size_t nsample) const
+  //******************************************************************
+  {
+    CheckRange(start, nsample);
+
+    return (_sum_v[start + nsample] - _sum_v[start]) / ((double)nsample);
+  }
+
+  //*******************************************************************
+  double WindowStats::Sigma(size_t start, size_t nsample) const
+  //*******************************************************************
+  {
+    CheckRange(start, nsample);
+
+    const int64_t sum = _sum_v[start + nsample] - _sum_v[start];
+    const int64_t sum2 = _sum2_v[start + nsample] - _sum2_v[start];
+    const double n = nsample;
+
+    // n * sum(x^2) - sum(x)^2 is exact in integer arithmetic as long as it fits;
+    // a flat window then gives exactly 0, as the direct computation does
+    double var = 0;
+    if (nsample <= (size_t(1) << 16))
+      var = (static_cast<int64_t>(nsample) * sum2 - sum * sum) / (n * n);
+    else
+      var = sum2 / n - (sum / n) * (sum / n);
+
+    return var > 0 ? sqrt(var) : 0.;
+  }
+
+  //*****************************************************************************
+  double ModeFinder::BinnedMaxOccurrence(const PedestalMean_t& v, const size_t nbins)
+  //*****************************************************************************
   {
     if (nbins < 1) throw OpticalRecoException("Cannot have 0 binning");
 
-    auto res = std::minmax_element(std::begin(mean_v), std::end(mean_v));
+    auto res = std::minmax_element(std::begin(v), std::end(v));
 
     double bin_width = ((*res.second) - (*res.first)) / ((double)nbins);
 
     if (nbins == 1 || bin_width == 0) return ((*res.first) + bin_width / 2.);
 
-    //std::cout<<"Min: "<<(*res.first)<<" Max: "<<(*res.second)<<" Width: "<<bin_width<<std::endl;
+    _ctr_v.assign(nbins, 0);
+    for (auto const& value : v) {
+      // the maximum value belongs to the last bin
+      size_t index = std::min(size_t((value - (*res.first)) / bin_width), nbins - 1);
+      _ctr_v[index]++;
+    }
+
+    return MeanOfMaxBins((*res.first) + bin_width / 2., bin_width);
+  }
 
-    // Construct array of nbins
-    static std::vector<size_t> ctr_v(nbins, 0);
-    for (auto& v : ctr_v)
-      v = 0;
-    for (auto const& v : mean_v) {
+  //***************************************************************************
+  double ModeFinder::MaxOccurrence(const PedestalMean_t& v, const unsigned int scale)
+  //***************************************************************************
+  {
+    if (scale < 1) throw OpticalRecoException("Cannot have 0 scale");
+    if (v.empty()) throw OpticalRecoException("Cannot find the mode of no value");
 
-      size_t index = int((v - (*res.first)) / bin_width);
-      //std::cout<<"adc = "<<v<<" width = "<<bin_width<< " ... "
-      //<<index<<" / "<<ctr_v.size()<<std::endl;
+    // the values are meant to be exact multiples of 1/scale: rounding only removes
+    // the floating point error of the division that produced them
+    auto res = std::minmax_element(std::begin(v), std::end(v));
+    const int64_t min_key = std::llround((*res.first) * scale);
+    const int64_t max_key = std::llround((*res.second) * scale);
 
-      ctr_v[index]++;
-    }
+    _ctr_v.assign(max_key - min_key + 1, 0);
+    for (auto const& value : v)
+      _ctr_v[std::llround(value * scale) - min_key]++;
 
+    return MeanOfMaxBins(min_key / (double)scale, 1. / scale);
+  }
+
+  //***************************************************************************
+  double ModeFinder::MeanOfMaxBins(double first_center, double bin_width) const
+  //***************************************************************************
+  {
     // Find max occurrence
-    auto max_it = std::max_element(std::begin(ctr_v), std::end(ctr_v));
+    auto max_it = std::max_element(std::begin(_ctr_v), std::end(_ctr_v));
 
     // Get the mean of max-occurrence bins
     double mean_max_occurrence = 0;
     double num_occurrence = 0;
-    for (size_t bin = 0; bin < ctr_v.size(); ++bin) {
+    for (size_t bin = 0; bin < _ctr_v.size(); ++bin) {
 
-      if (ctr_v[bin] != (*max_it)) continue;
+      if (_ctr_v[bin] != (*max_it)) continue;
 
-      mean_max_occurrence += ((*res.first) + bin_width / 2. + bin_width * bin);
+      mean_max_occurrence += (first_center + bin_width * bin);
 
       num_occurrence += 1.0;
     }
@@ -100,15 +190,6 @@ namespace pmtana {
     return (mean_max_occurrence / num_occurrence);
   }
 
-  // template<typename W>
-  int sign(double val)
-  {
-
-    if (val > 0) return 1;
-    if (val < 0) return -1;
-    return 0;
-  }
-
   double BinnedMaxTH1D(const std::vector<double>& v, int bins)
   {
 
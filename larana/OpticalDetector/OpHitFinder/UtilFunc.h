@@ -4,6 +4,7 @@
 #include "OpticalRecoTypes.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace pmtana {
@@ -17,12 +18,73 @@ namespace pmtana {
              size_t start = 0,
              size_t nsample = 0);
 
+  /// Mode of mean_v binned in nbins bins (see ModeFinder::BinnedMaxOccurrence)
   double BinnedMaxOccurrence(const PedestalMean_t& mean_v, const size_t nbins);
 
   double BinnedMaxTH1D(const std::vector<double>& v, int bins);
 
   int sign(double val);
 
+  /**
+   \class WindowStats
+   Running (prefix) sums of a waveform and of its squared samples.
+   Once filled, the mean and standard deviation of any window of samples are
+   available in constant time, regardless of the window length: sliding a window
+   across the whole waveform costs O(N) instead of O(N * window size).
+   The sums are kept in integer arithmetic, so results do not depend on where the
+   window sits in the waveform. Storage is reused across calls to `Fill()`.
+  */
+  class WindowStats {
+
+  public:
+    /// Computes the running sums of the input waveform
+    void Fill(const std::vector<short>& wf);
+
+    /// Number of samples of the last filled waveform
+    size_t Size() const { return _sum_v.empty() ? 0 : _sum_v.size() - 1; }
+
+    /// Mean of "nsample" samples from "start" index (same convention as pmtana::mean)
+    double Mean(size_t start = 0, size_t nsample = 0) const;
+
+    /// Standard deviation of "nsample" samples from "start" index, around their own mean
+    double Sigma(size_t start = 0, size_t nsample = 0) const;
+
+  private:
+    /// Checks the window boundaries, resolving nsample = 0 to "until the end"
+    void CheckRange(size_t start, size_t& nsample) const;
+
+    std::vector<int64_t> _sum_v;  ///< _sum_v[i] is the sum of the first i samples
+    std::vector<int64_t> _sum2_v; ///< _sum2_v[i] is the sum of the first i squared samples
+  };
+
+  /**
+   \class ModeFinder
+   Estimates the most frequent value of a set of samples.
+   The counting buffer belongs to the finder object, so that separate objects can
+   be used concurrently and reusing one object avoids a new allocation per call.
+   When several bins share the maximum count, the average of their centres is returned.
+  */
+  class ModeFinder {
+
+  public:
+    /// Mode of the values, binned in nbins equal bins between their minimum and maximum
+    double BinnedMaxOccurrence(const PedestalMean_t& v, const size_t nbins);
+
+    /**
+       Mode of values which are integer multiples of 1/scale, like ADC counts (scale 1)
+       or averages of scale ADC counts; each possible value gets its own bin
+       (counting sort), so the result does not depend on a binning choice.
+       The counting buffer spans the range of the values.
+    */
+    double MaxOccurrence(const PedestalMean_t& v, const unsigned int scale = 1);
+
+  private:
+    /// Average centre of the bins with the highest count
+    double MeanOfMaxBins(double first_center, double bin_width) const;
+
+    std::vector<size_t> _ctr_v; ///< Counting buffer
+  };
+
 }
 
 #endif
@@ -14,7 +14,6 @@
 #include "larana/OpticalDetector/OpHitFinder/OpHitAlg.h"
 #include "larana/OpticalDetector/OpHitFinder/PMTPedestalBase.h"
 #include "larana/OpticalDetector/OpHitFinder/PMTPulseRecoBase.h"
-#include "larana/OpticalDetector/OpHitFinder/PulseRecoManager.h"
 #include "larcore/CoreUtils/ServiceUtil.h" // lar::providerFrom()
 #include "larcore/Geometry/Geometry.h"
 #include "lardata/DetectorInfoServices/DetectorClocksService.h"
@@ -172,9 +171,9 @@ namespace opdet {
     std::vector<std::string> fInputLabels;
     std::set<unsigned int> fChannelMasks;
 
-    pmtana::PulseRecoManager fPulseRecoMgr;
-    std::unique_ptr<pmtana::PMTPulseRecoBase> const fThreshAlg;
-    std::unique_ptr<pmtana::PMTPedestalBase> const fPedAlg;
+    // Independent algorithm sets for concurrent processing of waveforms
+    // (only one when running serially)
+    std::vector<HitFinderWorker> fWorkers;
 
     Float_t fHitThreshold;
     unsigned int fMaxOpChannel;
@@ -195,9 +194,6 @@ namespace opdet {
   // Constructor
   OpHitFinder::OpHitFinder(const fhicl::ParameterSet& pset)
     : EDProducer{pset}
-    , fPulseRecoMgr()
-    , fThreshAlg{art::make_tool<opdet::IHitAlgoMakerTool>(makeHitAlgoToolConfig(pset))->makeAlgo()}
-    , fPedAlg{art::make_tool<opdet::IPedAlgoMakerTool>(makePedAlgoToolConfig(pset))->makeAlgo()}
   {
     // Indicate that the Input Module comes from .fcl
     fInputModule = pset.get<std::string>("InputModule");
@@ -210,6 +206,18 @@ namespace opdet {
       fChannelMasks.insert(ch);
 
     fHitThreshold = pset.get<float>("HitThreshold");
+
+    // Each worker owns its own algorithm instances; the maker tools create
+    // a new, independent one at each makeAlgo() call
+    unsigned int const nWorkers = pset.get<unsigned int>("NumWorkers", 1);
+    if (nWorkers == 0)
+      throw art::Exception(art::errors::Configuration) << "NumWorkers must be at least 1\n";
+    auto const hitAlgoMaker = art::make_tool<opdet::IHitAlgoMakerTool>(makeHitAlgoToolConfig(pset));
+    auto const pedAlgoMaker = art::make_tool<opdet::IPedAlgoMakerTool>(makePedAlgoToolConfig(pset));
+    fWorkers.reserve(nWorkers);
+    for (unsigned int i = 0; i < nWorkers; ++i)
+      fWorkers.emplace_back(hitAlgoMaker->makeAlgo(), pedAlgoMaker->makeAlgo());
+
     bool useCalibrator = pset.get<bool>("UseCalibrator", false);
 
     auto const& geometry(*lar::providerFrom<geo::Geometry>());
@@ -237,12 +245,21 @@ namespace opdet {
 
     produces<std::vector<recob::OpHit>>();
 
-    fPulseRecoMgr.AddRecoAlgo(fThreshAlg.get());
-    fPulseRecoMgr.SetDefaultPedAlgo(fPedAlg.get());
+    // Long waveforms can be reconstructed in chunks, to bound the memory
+    // used by the pulse algorithms regardless of the readout length
+    auto const chunkSize = pset.get<std::size_t>("ChunkSize", 0);
+    auto const chunkOverlap = pset.get<std::size_t>("ChunkOverlap", 0);
+    for (auto& worker : fWorkers)
+      worker.PulseRecoMgr().SetChunking(chunkSize, chunkOverlap);
 
     // show the algorithm selection on screen
-    mf::LogInfo{"OpHitFinder"} << "Pulse finder algorithm: '" << fThreshAlg->Name() << "'"
-                               << "\nPedestal algorithm:     '" << fPedAlg->Name() << "'";
+    mf::LogInfo{"OpHitFinder"} << "Pulse finder algorithm: '" << fWorkers.front().ThreshAlg().Name()
+                               << "'"
+                               << "\nPedestal algorithm:     '" << fWorkers.front().PedAlg().Name()
+                               << "'"
+                               << "\nConcurrent workers:     " << fWorkers.size()
+                               << "\nChunk size (overlap):   " << chunkSize << " (" << chunkOverlap
+                               << ")";
   }
 
   //----------------------------------------------------------------------------
@@ -264,6 +281,18 @@ namespace opdet {
     auto const clock_data =
       art::ServiceHandle<detinfo::DetectorClocksService const>()->DataFor(evt);
     auto const& calibrator(*fCalib);
+
+    // waveforms is either the waveform collection or pointers to selected waveforms
+    auto runHitFinder = [&](auto const& waveforms) {
+      RunHitFinder(waveforms,
+                   *HitPtr,
+                   fWorkers,
+                   geometry,
+                   fHitThreshold,
+                   clock_data,
+                   calibrator,
+                   fUseStartTime);
+    };
     //
     // Get the pulses from the event
     //
@@ -276,52 +305,33 @@ namespace opdet {
       else
         evt.getByLabel(fInputModule, fInputLabels.front(), wfHandle);
       assert(wfHandle.isValid());
-      RunHitFinder(*wfHandle,
-                   *HitPtr,
-                   fPulseRecoMgr,
-                   *fThreshAlg,
-                   geometry,
-                   fHitThreshold,
-                   clock_data,
-                   calibrator,
-                   fUseStartTime);
+      runHitFinder(*wfHandle);
     }
     else {
 
-      // Reserve a large enough array
+      // Collect the selected waveforms without copying them;
+      // the handles keep the data products alive for the whole event
       int totalsize = 0;
+      std::vector<art::Handle<std::vector<raw::OpDetWaveform>>> wfHandles;
       for (auto label : fInputLabels) {
         art::Handle<std::vector<raw::OpDetWaveform>> wfHandle;
         evt.getByLabel(fInputModule, label, wfHandle);
         if (!wfHandle.isValid()) continue; // Skip non-existent collections
         totalsize += wfHandle->size();
+        wfHandles.push_back(wfHandle);
       }
 
-      std::vector<raw::OpDetWaveform> WaveformVector;
+      std::vector<raw::OpDetWaveform const*> WaveformVector;
       WaveformVector.reserve(totalsize);
 
-      for (auto label : fInputLabels) {
-        art::Handle<std::vector<raw::OpDetWaveform>> wfHandle;
-        evt.getByLabel(fInputModule, label, wfHandle);
-        if (!wfHandle.isValid()) continue; // Skip non-existent collections
-
-        //WaveformVector.insert(WaveformVector.end(),
-        //                      wfHandle->begin(), wfHandle->end());
+      for (auto const& wfHandle : wfHandles) {
         for (auto const& wf : *wfHandle) {
           if (fChannelMasks.find(wf.ChannelNumber()) != fChannelMasks.end()) continue;
-          WaveformVector.push_back(wf);
+          WaveformVector.push_back(&wf);
         }
       }
 
-      RunHitFinder(WaveformVector,
-                   *HitPtr,
-                   fPulseRecoMgr,
-                   *fThreshAlg,
-                   geometry,
-                   fHitThreshold,
-                   clock_data,
-                   calibrator,
-                   fUseStartTime);
+      runHitFinder(WaveformVector);
     }
     // Store results into the event
     evt.put(std::move(HitPtr));
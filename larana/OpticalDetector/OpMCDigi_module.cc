@@ -36,7 +36,10 @@
 #include "nurandom/RandomUtils/NuRandomService.h"
 
 // C++ language includes
+#include <algorithm>
 #include <cstring>
+#include <utility>
+#include <vector>
 
 namespace opdet {
 
@@ -63,7 +66,9 @@ namespace opdet {
     CLHEP::RandFlat fFlatRandom;
     CLHEP::RandPoisson fPoissonRandom;
 
-    void AddTimedWaveform(int time, std::vector<double>& OldPulse, std::vector<double>& NewPulse);
+    std::vector<double> fPulses; // Waveforms of all channels, one after another (reused)
+
+    void AddTimedWaveform(int time, double* Pulse, double Scale) const;
   };
 }
 
@@ -94,18 +99,14 @@ namespace opdet {
 
   //-------------------------------------------------
 
-  void OpMCDigi::AddTimedWaveform(int binTime,
-                                  std::vector<double>& OldPulse,
-                                  std::vector<double>& NewPulse)
+  // Adds the single PE waveform, multiplied by Scale, to Pulse from binTime
+  // on. Pulse must have room for it: see the channel stride in produce().
+  void OpMCDigi::AddTimedWaveform(int binTime, double* Pulse, double Scale) const
   {
-
-    if ((binTime + NewPulse.size()) > OldPulse.size()) {
-      OldPulse.resize(binTime + NewPulse.size());
-    }
-
-    // Add shifted NewWaveform to Waveform at pointer
-    for (size_t i = 0; i != NewPulse.size(); ++i) {
-      OldPulse.at(binTime + i) += NewPulse.at(i);
+    // Add shifted single PE waveform to Waveform at pointer
+    double* const Start = Pulse + binTime;
+    for (size_t i = 0; i != fSinglePEWaveform.size(); ++i) {
+      Start[i] += fSinglePEWaveform[i] * Scale;
     }
   }
 
@@ -128,9 +129,15 @@ namespace opdet {
     int const nSamples = (TimeEnd_ns - TimeBegin_ns) * SampleFreq_ns;
     int const NOpChannels = odresponse->NOpChannels();
 
-    // This vector will store all the waveforms we will make
-    std::vector<std::vector<double>> PulsesFromDetPhotons(NOpChannels,
-                                                          std::vector<double>(nSamples, 0.0));
+    // This buffer will store all the waveforms we will make, one per channel.
+    // Times are truncated to samples, so no pulse starts later than one
+    // sample past the readout window (allowing for rounding): each channel
+    // has room for its nSamples samples, one more and a single PE waveform.
+    size_t const PulseStride = nSamples + fSinglePEWaveform.size() + 1;
+    fPulses.assign(NOpChannels * PulseStride, 0.0);
+    auto const PulsesFromDetPhotons = [this, PulseStride](int Ch) {
+      return fPulses.data() + Ch * PulseStride;
+    };
 
     if (!fUseLitePhotons) {
       // Read in the Sim Photons
@@ -154,34 +161,30 @@ namespace opdet {
           // that we have to accommodate for the beginning time
           if ((Phot.Time > TimeBegin_ns) && (Phot.Time < TimeEnd_ns)) {
             auto const binTime = static_cast<int>((Phot.Time - TimeBegin_ns) * SampleFreq_ns);
-            AddTimedWaveform(binTime, PulsesFromDetPhotons[readoutCh], fSinglePEWaveform);
+            AddTimedWaveform(binTime, PulsesFromDetPhotons(readoutCh), 1);
           }
         } // for each Photon in SimPhotons
       }
     }
     else {
-      auto const photons = *evt.getValidHandle<std::vector<sim::SimPhotonsLite>>("largeant");
+      auto const& photons = *evt.getValidHandle<std::vector<sim::SimPhotonsLite>>("largeant");
+      std::vector<std::pair<int, int>> nDetectedPerChannel;
       // For every OpDet:
       for (auto const& photon : photons) {
         int const Ch = photon.OpChannel;
-        int readoutCh;
-
-        std::map<int, int> PhotonsMap = photon.DetectedPhotons;
 
-        // For every photon in the hit:
+        // For every group of photons arriving at the same time:
         for (auto const& pr : photon.DetectedPhotons) {
-          for (int i = 0; i < pr.second; i++) {
-            // Sample a random subset according to QE
-            if (odresponse->detectedLite(Ch, readoutCh)) {
-              // Convert photon arrival time to the appropriate bin, dictated by fSampleFreq.
-              // Photon arrival time is in ns, beginning time in us, and sample frequency in MHz.
-              // Notice that we have to accommodate for the beginning time
-              if ((pr.first > TimeBegin_ns) && (pr.first < TimeEnd_ns)) {
-                auto const binTime = static_cast<int>((pr.first - TimeBegin_ns) * SampleFreq_ns);
-                AddTimedWaveform(binTime, PulsesFromDetPhotons[readoutCh], fSinglePEWaveform);
-              }
-            } // random QE cut
-          }
+          // Convert photon arrival time to the appropriate bin, dictated by fSampleFreq.
+          // Photon arrival time is in ns, beginning time in us, and sample frequency in MHz.
+          // Notice that we have to accommodate for the beginning time
+          if ((pr.first <= TimeBegin_ns) || (pr.first >= TimeEnd_ns)) continue;
+
+          // Sample a random subset according to QE, all the photons of the group at once
+          odresponse->detectedLite(Ch, pr.second, nDetectedPerChannel);
+          auto const binTime = static_cast<int>((pr.first - TimeBegin_ns) * SampleFreq_ns);
+          for (auto const& [readoutCh, nDetected] : nDetectedPerChannel)
+            AddTimedWaveform(binTime, PulsesFromDetPhotons(readoutCh), nDetected);
         } // for each Photon in SimPhotons
       }
     }
@@ -191,7 +194,11 @@ namespace opdet {
 
     std::vector<raw::OpDetPulse*> ThePulses(NOpChannels);
     for (int iCh = 0; iCh != NOpChannels; ++iCh) {
-      PulsesFromDetPhotons[iCh].resize((TimeEnd_ns - TimeBegin_ns) * SampleFreq_ns);
+      // Only the samples of the readout window are kept from the photons;
+      // dark noise pulses starting near its end extend the waveform
+      double* const ThePulse = PulsesFromDetPhotons(iCh);
+      std::fill(ThePulse + nSamples, ThePulse + PulseStride, 0.0);
+      size_t NSamplesOut = nSamples;
 
       // Add dark noise
       double const MeanDarkPulses = fDarkRate * (fTimeEnd - fTimeBegin) / 1000000;
@@ -201,22 +208,23 @@ namespace opdet {
         double const PulseTime = (fTimeEnd - fTimeBegin) * fFlatRandom.fire(1.0);
         int const binTime = static_cast<int>(PulseTime * fSampleFreq);
 
-        AddTimedWaveform(binTime, PulsesFromDetPhotons[iCh], fSinglePEWaveform);
+        AddTimedWaveform(binTime, ThePulse, 1);
+        NSamplesOut = std::max(NSamplesOut, binTime + fSinglePEWaveform.size());
       }
 
       // Apply saturation for large signals
-      for (size_t i = 0; i != PulsesFromDetPhotons[iCh].size(); ++i) {
-        if (PulsesFromDetPhotons[iCh].at(i) > fSaturationScale)
-          PulsesFromDetPhotons[iCh].at(i) = fSaturationScale;
+      for (size_t i = 0; i != NSamplesOut; ++i) {
+        if (ThePulse[i] > fSaturationScale) ThePulse[i] = fSaturationScale;
       }
 
       // Produce ADC pulse of integers rather than doubles
 
       std::vector<short> shortvec;
+      shortvec.reserve(NSamplesOut);
 
-      for (size_t i = 0; i != PulsesFromDetPhotons[iCh].size(); ++i) {
+      for (size_t i = 0; i != NSamplesOut; ++i) {
         // Throw randoms to fairly sample +ve and -ve side of doubles
-        int ThisSample = PulsesFromDetPhotons[iCh].at(i);
+        int ThisSample = ThePulse[i];
         if (ThisSample > 0) {
           if (fFlatRandom.fire(1.0) > (ThisSample - int(ThisSample)))
             shortvec.push_back(int(ThisSample));
@@ -231,7 +239,7 @@ namespace opdet {
         }
       }
 
-      StoragePtr->emplace_back(iCh, shortvec, 0, fTimeBegin);
+      StoragePtr->emplace_back(iCh, std::move(shortvec), 0, fTimeBegin);
 
     } // for each OpDet in SimPhotonsCollection
 
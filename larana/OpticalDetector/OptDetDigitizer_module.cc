@@ -19,6 +19,7 @@
 #include "art/Framework/Core/EDProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art/Framework/Principal/Event.h"
+#include "canvas/Persistency/Provenance/EventID.h"
 #include "art/Framework/Services/Registry/ServiceHandle.h"
 #include "fhiclcpp/ParameterSet.h"
 
@@ -26,10 +27,16 @@
 #include "nurandom/RandomUtils/NuRandomService.h"
 
 // CLHEP includes
+#include "CLHEP/Random/MixMaxRng.h"
 #include "CLHEP/Random/RandFlat.h"
 #include "CLHEP/Random/RandPoisson.h"
 
+// TBB includes
+#include "tbb/parallel_for.h"
+
 // C++ language includes
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 
 namespace opdet {
@@ -58,17 +65,27 @@ namespace opdet {
 
     bool fSimGainSpread;
 
-    CLHEP::HepRandomEngine& fEngine;
-    CLHEP::RandFlat fFlatRandom;
-    CLHEP::RandPoisson fPoissonRandom;
-    void AddDarkNoise(std::vector<double>& RawWF, double gain);
-    void AddWaveform(optdata::TimeSlice_t time,
-                     std::vector<double>& OldPulse,
-                     std::vector<double>& NewPulse,
-                     double factor,
-                     bool extend = false);
-    optdata::ChannelData ApplyDigitization(std::vector<double> const RawWF,
-                                           optdata::Channel_t const ch) const;
+    CLHEP::HepRandomEngine& fEngine; // Seeds the per-channel engines (see SeedChannelEngine)
+
+    void SeedChannelEngine(CLHEP::MixMaxRng& engine,
+                           art::EventID const& id,
+                           optdata::Channel_t const ch) const;
+    void DigitizeChannel(optdata::Channel_t const ch,
+                         sim::SimPhotons const* photons,
+                         art::EventID const& id,
+                         optdata::ChannelData& chData_HighGain,
+                         optdata::ChannelData& chData_LowGain) const;
+    void AddDarkNoise(std::vector<double>& RawWF,
+                      double gain,
+                      CLHEP::HepRandomEngine& engine,
+                      std::vector<double>& DarkPulseGains) const;
+    void AddSinglePEs(std::vector<double> const& GainPerTimeSlice,
+                      std::vector<double>& RawWF) const;
+    void ApplyDigitization(std::vector<double> const& RawWF,
+                           optdata::Channel_t const ch,
+                           CLHEP::HepRandomEngine& engine,
+                           std::vector<double>& Uniforms,
+                           optdata::ChannelData& chData) const;
     art::ServiceHandle<OpDigiProperties> fOpDigiProperties;
     art::ServiceHandle<geo::Geometry const> fGeom;
   };
@@ -80,13 +97,24 @@ namespace opdet {
 
 } //end namespace opdet
 
+namespace {
+
+  // SplitMix64 finaliser: folds numbers into a key with all its bits mixed
+  std::uint64_t Mix(std::uint64_t x)
+  {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+} // local namespace
+
 namespace opdet {
 
   OptDetDigitizer::OptDetDigitizer(fhicl::ParameterSet const& pset)
     : EDProducer{pset}
     , fEngine(art::ServiceHandle<rndm::NuRandomService>()->createEngine(*this, pset, "Seed"))
-    , fFlatRandom{fEngine}
-    , fPoissonRandom{fEngine}
   {
     // Infrastructure piece
     produces<std::vector<optdata::ChannelDataGroup>>();
@@ -110,36 +138,71 @@ namespace opdet {
 
   //-------------------------------------------------
 
-  void OptDetDigitizer::AddWaveform(optdata::TimeSlice_t const time,
-                                    std::vector<double>& OldPulse,
-                                    std::vector<double>& NewPulse,
-                                    double const factor,
-                                    bool const extend)
+  // Each channel of each event draws from its own MixMax stream, set by the
+  // module seed, the event ID and the channel number (MixMax gives distinct
+  // seed sets independent streams). The waveforms therefore do not depend
+  // on how many threads digitise the channels, nor in which order.
+  void OptDetDigitizer::SeedChannelEngine(CLHEP::MixMaxRng& engine,
+                                          art::EventID const& id,
+                                          optdata::Channel_t const ch) const
   {
-    if ((time + NewPulse.size()) > OldPulse.size() && extend)
-      OldPulse.resize(time + NewPulse.size());
-    for (size_t i = 0; i < NewPulse.size() && (time + i) < OldPulse.size(); ++i)
-      OldPulse[time + i] += NewPulse[i] * factor;
+    std::uint64_t const runKey = Mix(Mix(Mix(fEngine.getSeed()) ^ id.run()) ^ id.subRun());
+    long const seeds[4] = {
+      long(ch), long(id.event()), long(runKey & 0xffffffffULL), long(runKey >> 32)};
+    engine.setSeeds(seeds, 4);
   }
 
   //-------------------------------------------------
 
-  void OptDetDigitizer::AddDarkNoise(std::vector<double>& RawWF, double gain)
+  // Adds the single PE waveform at each time slice, scaled by the total gain
+  // of the photons there. This is the same as adding it photon by photon,
+  // in a time that depends on the length of the readout, not on the light.
+  void OptDetDigitizer::AddSinglePEs(std::vector<double> const& GainPerTimeSlice,
+                                     std::vector<double>& RawWF) const
+  {
+    size_t const nTimeSlices = std::min(GainPerTimeSlice.size(), RawWF.size());
+    for (size_t time = 0; time < nTimeSlices; ++time) {
+      double const gain = GainPerTimeSlice[time];
+      if (gain == 0) continue;
+      size_t const nSamples = std::min(fSinglePEWaveform.size(), RawWF.size() - time);
+      double* const pulse = RawWF.data() + time;
+      for (size_t i = 0; i < nSamples; ++i)
+        pulse[i] += fSinglePEWaveform[i] * gain;
+    }
+  }
+
+  //-------------------------------------------------
+
+  void OptDetDigitizer::AddDarkNoise(std::vector<double>& RawWF,
+                                     double gain,
+                                     CLHEP::HepRandomEngine& engine,
+                                     std::vector<double>& DarkPulseGains) const
   {
     // Add dark noise
     double MeanDarkPulses = fDarkRate * (fTimeEnd - fTimeBegin) / 1000000;
 
-    unsigned int NumberOfPulses = fPoissonRandom.fire(MeanDarkPulses);
+    unsigned int NumberOfPulses = CLHEP::RandPoisson(engine).fire(MeanDarkPulses);
+    if (NumberOfPulses == 0) return;
+
+    CLHEP::RandFlat flatRandom(engine);
+    DarkPulseGains.assign(RawWF.size(), 0.0);
     for (size_t i = 0; i != NumberOfPulses; ++i) {
       double PulseTime_ns = fTimeBegin * 1000 + (fTimeEnd - fTimeBegin) * 1000 *
-                                                  (fFlatRandom.fire(1.0)); // Should be in ns
+                                                  (flatRandom.fire(1.0)); // Should be in ns
       optdata::TimeSlice_t PulseTime_ts = fOpDigiProperties->GetTimeSlice(PulseTime_ns);
-      AddWaveform(PulseTime_ts, RawWF, fSinglePEWaveform, gain);
+      if (PulseTime_ts < DarkPulseGains.size()) DarkPulseGains[PulseTime_ts] += gain;
     }
+    AddSinglePEs(DarkPulseGains, RawWF);
   }
 
-  optdata::ChannelData OptDetDigitizer::ApplyDigitization(std::vector<double> const rawWF,
-                                                          optdata::Channel_t const ch) const
+  // Digitizes rawWF into chData. The random numbers of the amplitude
+  // digitization are drawn for the whole waveform at once (into Uniforms),
+  // which leaves the loop over the samples without calls or branches.
+  void OptDetDigitizer::ApplyDigitization(std::vector<double> const& rawWF,
+                                          optdata::Channel_t const ch,
+                                          CLHEP::HepRandomEngine& engine,
+                                          std::vector<double>& Uniforms,
+                                          optdata::ChannelData& chData) const
   {
     //
     // Digitization includes...
@@ -148,31 +211,38 @@ namespace opdet {
     //     (c) pedestal fluctuation
     //
 
-    // prepare return data container
-    optdata::ChannelData chData(ch);
-    chData.reserve(rawWF.size());
-    optdata::ADC_Count_t baseMean(fPedMeanArray.at(ch));
-    for (optdata::TimeSlice_t time = 0; time < rawWF.size(); ++time) {
-      double thisSample = rawWF[time];
+    CLHEP::RandFlat flatRandom(engine);
 
-      optdata::ADC_Count_t thisCount = (optdata::ADC_Count_t)(thisSample) + baseMean;
+    size_t const nSamples = rawWF.size();
+    Uniforms.resize(nSamples);
+    flatRandom.fireArray(nSamples, Uniforms.data());
 
-      // (a) amplitude digitization
-      if (CLHEP::RandFlat::shoot(1.0) < (thisSample - int(thisSample))) thisCount += 1;
+    // prepare return data container
+    chData = optdata::ChannelData(ch);
+    chData.resize(nSamples);
+
+    int const baseMean = fPedMeanArray.at(ch);
+    int const saturationScale = fSaturationScale;
+    double const* samples = rawWF.data();
+    double const* uniforms = Uniforms.data();
+    optdata::ADC_Count_t* counts = chData.data();
+    for (size_t time = 0; time < nSamples; ++time) {
+      // (a) amplitude digitization: the fractional count is rounded up with its probability
+      int const wholeCount = int(samples[time]);
+      int const thisCount =
+        wholeCount + baseMean + int(uniforms[time] < samples[time] - wholeCount);
 
       // (b) saturation
-      if (thisCount > fSaturationScale) thisCount = fSaturationScale;
-
-      chData.push_back(thisCount);
+      counts[time] = optdata::ADC_Count_t(std::min(thisCount, saturationScale));
     }
 
     // (c) pedestal fluctuation
     double timeSpan = chData.size() * 1.e-6 / (fOpDigiProperties->SampleFreq());
-    unsigned int nFluc = CLHEP::RandPoisson::shoot(fPedFlucRate * timeSpan);
+    unsigned int nFluc = CLHEP::RandPoisson(engine).fire(fPedFlucRate * timeSpan);
     for (size_t i = 0; i < nFluc; ++i) {
-      optdata::TimeSlice_t pulseTime(CLHEP::RandFlat::shoot(0.0, (double)(chData.size())));
+      optdata::TimeSlice_t pulseTime(flatRandom.fire(0.0, (double)(chData.size())));
       optdata::ADC_Count_t amp = chData[pulseTime];
-      if (CLHEP::RandFlat::shoot(0., 1.) > 0.5) {
+      if (flatRandom.fire(0., 1.) > 0.5) {
         amp += fPedFlucAmp;
         if (amp > fSaturationScale) amp = fSaturationScale;
       }
@@ -180,26 +250,19 @@ namespace opdet {
         amp -= fPedFlucAmp;
       chData[pulseTime] = amp;
     }
-
-    return chData;
   }
 
   //-------------------------------------------------
 
-  void OptDetDigitizer::produce(art::Event& evt)
+  void OptDetDigitizer::DigitizeChannel(optdata::Channel_t const ch,
+                                        sim::SimPhotons const* photons,
+                                        art::EventID const& id,
+                                        optdata::ChannelData& chData_HighGain,
+                                        optdata::ChannelData& chData_LowGain) const
   {
-
-    //
-    // Event-wise initialization
-    //
-
-    // Infrastructure piece
-    std::unique_ptr<std::vector<optdata::ChannelDataGroup>> StoragePtr(
-      new std::vector<optdata::ChannelDataGroup>);
-
-    // Read in the Sim Photons
-    sim::SimPhotonsCollection ThePhotCollection =
-      sim::SimListUtils::GetSimPhotonsCollection(evt, fInputModule);
+    CLHEP::MixMaxRng engine;
+    SeedChannelEngine(engine, id, ch);
+    CLHEP::RandFlat flatRandom(engine);
 
     // Convert units into ns from us/MHz
     double timeBegin_ns = fTimeBegin * 1000;
@@ -210,63 +273,36 @@ namespace opdet {
     optdata::TimeSlice_t timeSliceWindow(fOpDigiProperties->GetTimeSlice(timeEnd_ns));
 
     /*
-      Create output data product, optdata::ChannelDataGroup for each gain channel.
-      Note : Although the frame + sample number in DATA should have a reference of T=0 @ DAQ start time, this is
-             not handled in MC. Hence we do not set them here (use constructor default)
-    */
-    optdata::ChannelDataGroup rawWFGroup_HighGain(optdata::kHighGain);
-    optdata::ChannelDataGroup rawWFGroup_LowGain(optdata::kLowGain);
-    // Reserve entries equal to # of channels
-    rawWFGroup_HighGain.reserve(fGeom->NOpChannels());
-    rawWFGroup_LowGain.reserve(fGeom->NOpChannels());
-
-    /*
-      Define "raw" waveform container which will be filled based on G4 photon timing + SPE waveform information.
-      Note this is not completely an analog waveform because it is digitized in terms of time (as it is using std::vector).
+      Define the container of the total gain of the detected photons in each time slice.
+      The "raw" waveform is this histogram convolved with the SPE waveform.
     */
-    std::vector<std::vector<double>> rawWF_HighGain(fGeom->NOpChannels(),
-                                                    std::vector<double>(timeSliceWindow, 0.0));
-    std::vector<std::vector<double>> rawWF_LowGain(fGeom->NOpChannels(),
-                                                   std::vector<double>(timeSliceWindow, 0.0));
+    std::vector<double> gains_HighGain(timeSliceWindow, 0.0);
+    std::vector<double> gains_LowGain(timeSliceWindow, 0.0);
 
     /*
       Start data processing ... see following steps
-      (1) Loop over input array of optical photons & fill "raw" waveform container w/ corresponding SPE waveform
-      (2) Loop over filled "raw" waveform and process (digitization, adding noise, baseline spread, etc)
+      (1) Loop over the photons of the channel & fill the gain histograms w/ each detected photon
+      (2) Make the "raw" waveform from the histograms and process it
+          (digitization, adding noise, baseline spread, etc)
     */
 
     //
     // Step (1) ... loop over G4 optical photons
     //
-
-    // For every OpDet, convert PE into waveform and combine all together
-    for (sim::SimPhotonsCollection::const_iterator itOpDet = ThePhotCollection.begin();
-         itOpDet != ThePhotCollection.end();
-         itOpDet++) {
-      const sim::SimPhotons& ThePhot = itOpDet->second;
-
-      int ch = ThePhot.OpChannel();
+    if (photons) {
       // For every photon in the hit:
-      for (const sim::OnePhoton& Phot : ThePhot) {
+      for (const sim::OnePhoton& Phot : *photons) {
         // Sample a random subset according to QE
-        if (fFlatRandom.fire(1.0) <= fQE) {
+        if (flatRandom.fire(1.0) <= fQE) {
           optdata::TimeSlice_t PhotonTime(fOpDigiProperties->GetTimeSlice(Phot.Time));
           if (Phot.Time > timeBegin_ns && Phot.Time < timeEnd_ns) {
-            if (fSimGainSpread) {
-              AddWaveform(
-                PhotonTime, rawWF_HighGain[ch], fSinglePEWaveform, fOpDigiProperties->HighGain(ch));
-              AddWaveform(
-                PhotonTime, rawWF_LowGain[ch], fSinglePEWaveform, fOpDigiProperties->LowGain(ch));
-            }
-            else {
-              AddWaveform(PhotonTime,
-                          rawWF_HighGain[ch],
-                          fSinglePEWaveform,
-                          fOpDigiProperties->HighGainMean(ch));
-              AddWaveform(PhotonTime,
-                          rawWF_LowGain[ch],
-                          fSinglePEWaveform,
-                          fOpDigiProperties->LowGainMean(ch));
+            double const highGain = fSimGainSpread ? fOpDigiProperties->HighGain(ch, engine) :
+                                                     fOpDigiProperties->HighGainMean(ch);
+            double const lowGain = fSimGainSpread ? fOpDigiProperties->LowGain(ch, engine) :
+                                                    fOpDigiProperties->LowGainMean(ch);
+            if (PhotonTime < timeSliceWindow) {
+              gains_HighGain[PhotonTime] += highGain;
+              gains_LowGain[PhotonTime] += lowGain;
             }
           }
         } // random QE cut
@@ -274,32 +310,81 @@ namespace opdet {
     }
 
     //
-    // Loop over "raw" waveform (channel-wise)
+    // Step (2) ... "raw" waveform
     //
-    for (unsigned short iCh = 0; iCh < rawWF_LowGain.size(); ++iCh) {
-      rawWF_LowGain[iCh].resize((timeEnd_ns - timeBegin_ns) * sampleFreq_ns);
-      rawWF_HighGain[iCh].resize((timeEnd_ns - timeBegin_ns) * sampleFreq_ns);
-
-      // Add dark noise
-      if (fSimGainSpread) {
-        AddDarkNoise(rawWF_LowGain[iCh], fOpDigiProperties->LowGain(iCh));
-        AddDarkNoise(rawWF_HighGain[iCh], fOpDigiProperties->HighGain(iCh));
-      }
-      else {
-        AddDarkNoise(rawWF_LowGain[iCh], fOpDigiProperties->LowGainMean(iCh));
-        AddDarkNoise(rawWF_HighGain[iCh], fOpDigiProperties->HighGainMean(iCh));
-      }
 
-      // Apply digitization and make channel data
-      optdata::ChannelData chData_HighGain(ApplyDigitization(rawWF_HighGain[iCh], iCh));
-      optdata::ChannelData chData_LowGain(ApplyDigitization(rawWF_LowGain[iCh], iCh));
+    // Convolve the photons with the SPE waveform
+    std::vector<double> rawWF_HighGain(timeSliceWindow, 0.0);
+    std::vector<double> rawWF_LowGain(timeSliceWindow, 0.0);
+    AddSinglePEs(gains_LowGain, rawWF_LowGain);
+    AddSinglePEs(gains_HighGain, rawWF_HighGain);
 
-      rawWFGroup_HighGain.push_back(chData_HighGain);
-      rawWFGroup_LowGain.push_back(chData_LowGain);
-    } // for each OpDet in SimPhotonsCollection
+    rawWF_LowGain.resize((timeEnd_ns - timeBegin_ns) * sampleFreq_ns);
+    rawWF_HighGain.resize((timeEnd_ns - timeBegin_ns) * sampleFreq_ns);
+
+    // Add dark noise (the photon gain histogram is reused for the dark pulses)
+    if (fSimGainSpread) {
+      AddDarkNoise(rawWF_LowGain, fOpDigiProperties->LowGain(ch, engine), engine, gains_LowGain);
+      AddDarkNoise(
+        rawWF_HighGain, fOpDigiProperties->HighGain(ch, engine), engine, gains_HighGain);
+    }
+    else {
+      AddDarkNoise(rawWF_LowGain, fOpDigiProperties->LowGainMean(ch), engine, gains_LowGain);
+      AddDarkNoise(rawWF_HighGain, fOpDigiProperties->HighGainMean(ch), engine, gains_HighGain);
+    }
+
+    // Apply digitization and make channel data (the photon gain histogram
+    // holds the random numbers of the digitization this time)
+    ApplyDigitization(rawWF_HighGain, ch, engine, gains_HighGain, chData_HighGain);
+    ApplyDigitization(rawWF_LowGain, ch, engine, gains_LowGain, chData_LowGain);
+  }
+
+  //-------------------------------------------------
+
+  void OptDetDigitizer::produce(art::Event& evt)
+  {
+
+    //
+    // Event-wise initialization
+    //
 
-    StoragePtr->push_back(rawWFGroup_HighGain);
-    StoragePtr->push_back(rawWFGroup_LowGain);
+    // Infrastructure piece
+    std::unique_ptr<std::vector<optdata::ChannelDataGroup>> StoragePtr(
+      new std::vector<optdata::ChannelDataGroup>);
+
+    // Read in the Sim Photons
+    sim::SimPhotonsCollection ThePhotCollection =
+      sim::SimListUtils::GetSimPhotonsCollection(evt, fInputModule);
+
+    unsigned int const nChannels = fGeom->NOpChannels();
+
+    // The photons of each channel
+    std::vector<sim::SimPhotons const*> photonsPerChannel(nChannels, nullptr);
+    for (auto const& [key, ThePhot] : ThePhotCollection) {
+      int const ch = ThePhot.OpChannel();
+      if (ch >= 0 && (unsigned int)ch < nChannels) photonsPerChannel[ch] = &ThePhot;
+    }
+
+    /*
+      Create output data product, optdata::ChannelDataGroup for each gain channel.
+      Note : Although the frame + sample number in DATA should have a reference of T=0 @ DAQ start time, this is
+             not handled in MC. Hence we do not set them here (use constructor default)
+    */
+    optdata::ChannelDataGroup rawWFGroup_HighGain(optdata::kHighGain);
+    optdata::ChannelDataGroup rawWFGroup_LowGain(optdata::kLowGain);
+    // One entry per channel, filled in place by the channel digitisation
+    rawWFGroup_HighGain.resize(nChannels);
+    rawWFGroup_LowGain.resize(nChannels);
+
+    // Channels are independent, each with its own random stream
+    art::EventID const id = evt.id();
+    tbb::parallel_for(0U, nChannels, [&](unsigned int const iCh) {
+      DigitizeChannel(
+        iCh, photonsPerChannel[iCh], id, rawWFGroup_HighGain[iCh], rawWFGroup_LowGain[iCh]);
+    });
+
+    StoragePtr->push_back(std::move(rawWFGroup_HighGain));
+    StoragePtr->push_back(std::move(rawWFGroup_LowGain));
 
     evt.put(std::move(StoragePtr));
   }
@@ -0,0 +1,15 @@
+/**
+ * @file   larana/OpticalDetector/PedAlgoRmsSliderMaker_tool.cc
+ * @brief  _art_ tool to create a `pmtana::PedAlgoRmsSlider` algorithm.
+ * @date   October 15, 2026
+ */
+
+// LArSoft libraries
+#include "larana/OpticalDetector/OpHitFinder/PedAlgoRmsSlider.h"
+#include "larana/OpticalDetector/PedAlgoMakerToolBase.h"
+
+// framework libraries
+#include "art/Utilities/ToolMacros.h"
+
+// -----------------------------------------------------------------------------
+DEFINE_ART_CLASS_TOOL(opdet::PedAlgoMakerToolBase<pmtana::PedAlgoRmsSlider>)
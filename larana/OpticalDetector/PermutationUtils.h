@@ -0,0 +1,69 @@
+#ifndef PERMUTATIONUTILS_H
+#define PERMUTATIONUTILS_H
+
+/*!
+ * Title:   Permutation utilities
+ *
+ * Description:
+ * Sorting of data held as parallel arrays (e.g. flashes and the hits of each
+ * flash): the permutation is found once from one of the arrays, then applied
+ * to all of them in place, following its cycles, without copying the arrays.
+ *
+ *     auto p = opdet::sort_permutation(flashes.begin(), flashes.end(), byTime);
+ *     opdet::apply_permutation(p, flashes.begin(), hitsPerFlash.begin());
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace opdet {
+
+  /// Positions of the elements in [first, last) in the order given by compare;
+  /// elements that compare equal keep their relative order. The positions are
+  /// written into p, reusing its memory.
+  template <typename RandomIt, typename Compare>
+  void sort_permutation(RandomIt first, RandomIt last, Compare compare, std::vector<std::size_t>& p)
+  {
+    p.resize(std::distance(first, last));
+    std::iota(p.begin(), p.end(), 0);
+    std::stable_sort(p.begin(), p.end(), [&](std::size_t i, std::size_t j) {
+      return compare(first[i], first[j]);
+    });
+  }
+
+  /// Same as above, returning the positions.
+  template <typename RandomIt, typename Compare>
+  std::vector<std::size_t> sort_permutation(RandomIt first, RandomIt last, Compare compare)
+  {
+    std::vector<std::size_t> p;
+    sort_permutation(first, last, compare, p);
+    return p;
+  }
+
+  /// Reorders each of the ranges starting at firsts so that its element i
+  /// becomes its element p[i], for all the p.size() elements. Elements are
+  /// swapped along the cycles of p; p is used as the record of which elements
+  /// are in place, and is left as the identity.
+  template <typename... RandomIts>
+  void apply_permutation(std::vector<std::size_t>& p, RandomIts... firsts)
+  {
+    using std::swap;
+    for (std::size_t i = 0; i != p.size(); ++i) {
+      std::size_t j = i;
+      while (p[j] != i) {
+        std::size_t const next = p[j];
+        (swap(firsts[j], firsts[next]), ...);
+        p[j] = j;
+        j = next;
+      }
+      p[j] = j;
+    }
+  }
+
+}
+
+#endif
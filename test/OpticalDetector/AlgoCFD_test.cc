@@ -0,0 +1,106 @@
+#define BOOST_TEST_MODULE (AlgoCFD_test)
+#include "boost/test/unit_test.hpp"
+
+#include "larana/OpticalDetector/OpHitFinder/AlgoCFD.h"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <vector>
+
+constexpr short Baseline = 2000;
+constexpr size_t Gap = 20;
+
+// The CFD crossing is interpolated with a single precision fraction
+auto const tolerance = 1e-6 % boost::test_tools::tolerance();
+
+fhicl::ParameterSet CFDPset()
+{
+  fhicl::ParameterSet pset;
+  pset.put("Fraction", 0.9);
+  pset.put("Delay", 2);
+  pset.put("PeakThresh", 7.5);
+  pset.put("StartThresh", 5.0);
+  pset.put("EndThresh", 1.5);
+  return pset;
+}
+
+// Noiseless waveform with the pulse shapes (ADC above baseline) separated by flat gaps
+pmtana::Waveform_t MakeWaveform(std::vector<std::vector<short>> const& shapes)
+{
+  pmtana::Waveform_t wf(Gap, Baseline);
+  for (auto const& shape : shapes) {
+    for (short adc : shape)
+      wf.push_back(Baseline + adc);
+    wf.insert(wf.end(), Gap, Baseline);
+  }
+  return wf;
+}
+
+struct ExpectedPulse {
+  int t_start;
+  int t_max;
+  int t_end;
+  double t_cfdcross;
+  double peak;
+  double area;
+};
+
+void CheckPulses(pmtana::pulse_param_array const& pulses,
+                 std::vector<ExpectedPulse> const& expected)
+{
+  BOOST_TEST(pulses.size() == expected.size());
+  for (size_t i = 0; i < std::min(pulses.size(), expected.size()); ++i) {
+    BOOST_TEST_CONTEXT("pulse " << i)
+    {
+      BOOST_TEST(pulses[i].t_start == expected[i].t_start);
+      BOOST_TEST(pulses[i].t_max == expected[i].t_max);
+      BOOST_TEST(pulses[i].t_end == expected[i].t_end);
+      BOOST_TEST(pulses[i].t_cfdcross == expected[i].t_cfdcross, tolerance);
+      BOOST_TEST(pulses[i].peak == expected[i].peak);
+      BOOST_TEST(pulses[i].area == expected[i].area);
+      BOOST_TEST(pulses[i].ped_mean == Baseline);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(AlgoCFD_test)
+
+BOOST_AUTO_TEST_CASE(RecoPulse_MergesCrossingsOfOnePulse)
+{
+  auto const wf = MakeWaveform({
+    // two CFD crossings (ticks 22 and 25) walking back to the same start
+    {20, 40, 30, 25, 35, 50, 30, 15, 8, 4, 2, 1},
+    // a dip below the start but not the end threshold: crossings at ticks 54 and 59
+    // have different starts (51 and 56) and the same end
+    {20, 40, 30, 10, 3, 10, 35, 50, 30, 15, 8, 4, 2, 1},
+    // two separate pulses, which are both kept
+    {20, 40, 30, 15, 8, 4, 1, 0, 20, 40, 30, 15, 8, 4, 1},
+  });
+  pmtana::PedestalMean_t const mean(wf.size(), Baseline);
+  pmtana::PedestalSigma_t const sigma(wf.size(), 1.0);
+
+  pmtana::AlgoCFD cfd(CFDPset(), nullptr);
+  BOOST_TEST(cfd.Reconstruct(wf, mean, sigma));
+
+  // In time order; a shared start keeps the first crossing,
+  // a shared end the pulse with the earliest start
+  CheckPulses(cfd.GetPulses(),
+              {
+                {19, 25, 31, 22. + 7. / 24.5, 50., 260.},
+                {51, 59, 65, 54. + 7. / 38., 50., 258.},
+                {85, 87, 92, 88. + 7. / 33.5, 40., 118.},
+                {93, 95, 100, 96. + 7. / 33.5, 40., 118.},
+              });
+}
+
+BOOST_AUTO_TEST_CASE(RecoPulse_FlatWaveformHasNoPulse)
+{
+  auto const wf = MakeWaveform({});
+  pmtana::AlgoCFD cfd(CFDPset(), nullptr);
+  BOOST_TEST(cfd.Reconstruct(wf,
+                             pmtana::PedestalMean_t(wf.size(), Baseline),
+                             pmtana::PedestalSigma_t(wf.size(), 1.0)));
+  BOOST_TEST(cfd.GetNPulse() == 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
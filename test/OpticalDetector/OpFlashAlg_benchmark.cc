@@ -0,0 +1,209 @@
+// Throughput of the OpFlashAlg stages on synthetic hit populations.
+//
+// Usage: OpFlashAlg_benchmark [max hits]   (default 1000000)
+//
+// Hits are generated for three scenarios (a beam spill, cosmic pile-up over
+// the readout window and noise only) with 10^2 hits up to the maximum, and
+// the time of each stage is printed per call. Flash construction needs the
+// geometry and clock services, and is not timed here; the late light stage
+// runs on flashes with the time, width and total PE of the refined flashes.
+
+#include "larana/OpticalDetector/OpFlashAlg.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+  constexpr double BinWidth = 1;         // us, as standard_opflash
+  constexpr float FlashThreshold = 2;    // PE
+  constexpr float WidthTolerance = 0.5;  // unitless
+  constexpr double ReadoutStart = -1000; // us
+  constexpr double ReadoutEnd = 3000;    // us
+  constexpr int NChannels = 300;
+
+  using HitGenerator = std::function<std::vector<recob::OpHit>(std::mt19937&, size_t)>;
+
+  // Hits of one flash at time t0: a prompt component and a 1.6 us slow tail
+  void AddFlashHits(std::mt19937& engine,
+                    double const t0,
+                    size_t const NHits,
+                    std::vector<recob::OpHit>& HitVector)
+  {
+    std::uniform_int_distribution<int> channel(0, NChannels - 1);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::exponential_distribution<double> slow(1 / 1.6);
+    std::exponential_distribution<double> fast(1 / 0.006);
+    std::lognormal_distribution<double> pe(0.5, 0.8);
+
+    for (size_t i = 0; i < NHits; ++i) {
+      double const time = t0 + (uniform(engine) < 0.3 ? fast(engine) : slow(engine));
+      double const PE = pe(engine);
+      HitVector.emplace_back(channel(engine),
+                             time,
+                             time,
+                             0,
+                             0.01 + 0.1 * uniform(engine),
+                             PE * 20,
+                             PE * 5,
+                             PE,
+                             uniform(engine));
+    }
+  }
+
+  std::vector<recob::OpHit> BeamSpill(std::mt19937& engine, size_t const NHits)
+  {
+    std::vector<recob::OpHit> HitVector;
+    HitVector.reserve(NHits);
+    AddFlashHits(engine, 0, NHits, HitVector);
+    return HitVector;
+  }
+
+  std::vector<recob::OpHit> CosmicPileUp(std::mt19937& engine, size_t const NHits)
+  {
+    std::uniform_real_distribution<double> t0(ReadoutStart, ReadoutEnd);
+    size_t const HitsPerFlash = 100;
+
+    std::vector<recob::OpHit> HitVector;
+    HitVector.reserve(NHits);
+    while (HitVector.size() < NHits)
+      AddFlashHits(
+        engine, t0(engine), std::min(HitsPerFlash, NHits - HitVector.size()), HitVector);
+    return HitVector;
+  }
+
+  std::vector<recob::OpHit> NoiseOnly(std::mt19937& engine, size_t const NHits)
+  {
+    std::uniform_int_distribution<int> channel(0, NChannels - 1);
+    std::uniform_real_distribution<double> time(ReadoutStart, ReadoutEnd);
+    std::uniform_real_distribution<double> pe(0.5, 1.5);
+
+    std::vector<recob::OpHit> HitVector;
+    HitVector.reserve(NHits);
+    for (size_t i = 0; i < NHits; ++i) {
+      double const t = time(engine);
+      double const PE = pe(engine);
+      HitVector.emplace_back(channel(engine), t, t, 0, 0.02, PE * 20, PE * 5, PE, 0.5);
+    }
+    return HitVector;
+  }
+
+  // Milliseconds per call of f, repeated for at least 0.1 s on small inputs
+  double TimeIt(std::function<void()> const& f)
+  {
+    using clock = std::chrono::steady_clock;
+    unsigned int NCalls = 0;
+    auto const start = clock::now();
+    std::chrono::duration<double, std::milli> elapsed{0};
+    do {
+      f();
+      ++NCalls;
+      elapsed = clock::now() - start;
+    } while (elapsed.count() < 100 && NCalls < 1000);
+    return elapsed.count() / NCalls;
+  }
+
+  // Stand-ins for the flashes of ConstructFlash, with what late light removal uses
+  std::vector<recob::OpFlash> SimpleFlashes(opdet::HitIndexLists const& HitsPerFlash,
+                                            std::vector<recob::OpHit> const& HitVector)
+  {
+    std::vector<recob::OpFlash> FlashVector;
+    FlashVector.reserve(HitsPerFlash.NLists());
+    for (size_t iFlash = 0; iFlash != HitsPerFlash.NLists(); ++iFlash) {
+      double TotalPE = 0, AveTime = 0;
+      double MaxTime = -std::numeric_limits<double>::max();
+      double MinTime = std::numeric_limits<double>::max();
+      for (int const* HitID = HitsPerFlash.Begin(iFlash); HitID != HitsPerFlash.End(iFlash);
+           ++HitID) {
+        auto const& hit = HitVector[*HitID];
+        TotalPE += hit.PE();
+        AveTime += hit.PE() * hit.PeakTime();
+        MaxTime = std::max(MaxTime, hit.PeakTime());
+        MinTime = std::min(MinTime, hit.PeakTime());
+      }
+      FlashVector.emplace_back(
+        AveTime / TotalPE, (MaxTime - MinTime) / 2.0, AveTime / TotalPE, 1, std::vector{TotalPE});
+    }
+    return FlashVector;
+  }
+
+} // local namespace
+
+int main(int argc, char** argv)
+{
+  size_t const MaxHits = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+  std::vector<std::pair<std::string, HitGenerator>> const Scenarios{
+    {"beam spill", BeamSpill}, {"cosmic pile-up", CosmicPileUp}, {"noise only", NoiseOnly}};
+
+  std::printf("%-15s %8s %8s %8s %12s %12s %12s %12s %12s\n",
+              "scenario",
+              "hits",
+              "refined",
+              "flashes",
+              "binned [ms]",
+              "sweep [ms]",
+              "assign [ms]",
+              "refine [ms]",
+              "late [ms]");
+
+  for (auto const& [Name, Generate] : Scenarios) {
+    for (size_t NHits = 100; NHits <= MaxHits; NHits *= 10) {
+
+      std::mt19937 engine(12345);
+      std::vector<recob::OpHit> const HitVector = Generate(engine, NHits);
+
+      // One workspace for all the calls, as the module keeps between events
+      opdet::OpFlashWorkspace Workspace;
+      double const BinnedTime = TimeIt([&] {
+        opdet::FillAccumulators(HitVector, BinWidth, FlashThreshold, false, Workspace);
+      });
+      double const SweepTime = TimeIt([&] {
+        opdet::FillAccumulators(HitVector, BinWidth, FlashThreshold, true, Workspace);
+      });
+      double const AssignTime =
+        TimeIt([&] { opdet::AssignHitsToFlash(HitVector, FlashThreshold, Workspace); });
+      double const RefineTime = TimeIt([&] {
+        opdet::RefineHitsInFlash(HitVector, WidthTolerance, FlashThreshold, Workspace);
+      });
+
+      opdet::HitIndexLists const& RefinedHitsPerFlash = Workspace.RefinedHitsPerFlash;
+      std::vector<std::vector<int>> HitsPerRefinedFlash;
+      for (size_t iFlash = 0; iFlash != RefinedHitsPerFlash.NLists(); ++iFlash)
+        HitsPerRefinedFlash.emplace_back(RefinedHitsPerFlash.Begin(iFlash),
+                                         RefinedHitsPerFlash.End(iFlash));
+
+      std::vector<recob::OpFlash> const Flashes = SimpleFlashes(RefinedHitsPerFlash, HitVector);
+      std::vector<recob::OpFlash> FlashVector;
+      std::vector<std::vector<int>> HitsKept;
+      // (this includes making a fresh copy of the flashes at each call)
+      double const LateLightTime = TimeIt([&] {
+        FlashVector = Flashes;
+        HitsKept = HitsPerRefinedFlash;
+        opdet::RemoveLateLight(FlashVector, HitsKept);
+      });
+
+      std::printf("%-15s %8zu %8zu %8zu %12.3f %12.3f %12.3f %12.3f %12.3f\n",
+                  Name.c_str(),
+                  NHits,
+                  HitsPerRefinedFlash.size(),
+                  FlashVector.size(),
+                  BinnedTime,
+                  SweepTime,
+                  AssignTime,
+                  RefineTime,
+                  LateLightTime);
+    }
+  }
+
+  return 0;
+}
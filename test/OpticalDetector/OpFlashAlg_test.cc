@@ -3,6 +3,11 @@
 
 #include "larana/OpticalDetector/OpFlashAlg.h"
 
+#include "cetlib_except/exception.h"
+#include "lardataalg/DetectorInfo/DetectorClocksData.h"
+#include "lardataalg/DetectorInfo/ElecClock.h"
+
+#include <algorithm> // std::min
 #include <cmath> // std::exp
 
 constexpr float FlashThreshold = 50;
@@ -214,6 +219,147 @@ BOOST_AUTO_TEST_CASE(FillFlashesBySizeMap_checkTwoAccumulators)
   BOOST_TEST(FlashesBySize[60][1][0] == 5);
 }
 
+BOOST_AUTO_TEST_CASE(SweepAccumulator_SameFlashesBySizeMap)
+{
+  // Hits out of time order, with equal-size flashes
+  // and bins below threshold in both accumulators
+  std::vector<double> const Times{7.6, 0.2, 3.4, 0.7, 7.9, 3.1, 5.5, 0.4, 7.2, 3.6, 9.9};
+  std::vector<double> const PEs{20, 30, 10, 25, 15, 20, 60, 10, 25, 30, 55};
+
+  std::vector<recob::OpHit> HitVector;
+  for (size_t i = 0; i < Times.size(); i++)
+    HitVector.emplace_back(0, Times[i], 0, 0, 0, 0, 0, PEs[i], 0);
+
+  double const MinTime = 0.2;
+  double const BinWidth = 1;
+  std::vector<int> const HitsByTime = opdet::SortHitsByTime(HitVector);
+  BOOST_TEST(HitsByTime.front() == 1);
+  BOOST_TEST(HitsByTime.back() == 10);
+
+  for (int Accumulator = 1; Accumulator <= 2; Accumulator++) {
+    double const BinOffset = (Accumulator - 1) * BinWidth / 2.0;
+
+    std::vector<double> Binned(20);
+    std::vector<std::vector<int>> Contributors(20);
+    std::vector<int> FlashesInAccumulator;
+    for (size_t i = 0; i < HitVector.size(); i++)
+      opdet::FillAccumulator(opdet::GetAccumIndex(Times[i], MinTime, BinWidth, BinOffset),
+                             i,
+                             PEs[i],
+                             FlashThreshold,
+                             Binned,
+                             Contributors,
+                             FlashesInAccumulator);
+
+    std::vector<double> SweptBinned;
+    std::vector<std::vector<int>> SweptContributors;
+    std::vector<int> SweptFlashesInAccumulator;
+    opdet::SweepAccumulator(HitsByTime,
+                            HitVector,
+                            MinTime,
+                            BinWidth,
+                            BinOffset,
+                            FlashThreshold,
+                            SweptBinned,
+                            SweptContributors,
+                            SweptFlashesInAccumulator);
+
+    std::map<double, std::map<int, std::vector<int>>, std::greater<double>> FlashesBySize;
+    std::map<double, std::map<int, std::vector<int>>, std::greater<double>> SweptFlashesBySize;
+    opdet::FillFlashesBySizeMap(FlashesInAccumulator, Binned, Accumulator, FlashesBySize);
+    opdet::FillFlashesBySizeMap(
+      SweptFlashesInAccumulator, SweptBinned, Accumulator, SweptFlashesBySize);
+
+    BOOST_TEST(FlashesBySize.size() > 1U);
+    BOOST_TEST(SweptFlashesBySize.size() == FlashesBySize.size());
+    for (auto const& itFlash : FlashesBySize) {
+      BOOST_TEST(SweptFlashesBySize.count(itFlash.first) == 1U);
+      auto const& Bins = itFlash.second.at(Accumulator);
+      auto const& SweptBins = SweptFlashesBySize[itFlash.first][Accumulator];
+      BOOST_TEST(SweptBins.size() == Bins.size());
+      // Swept bins are numbered differently, but hold the same hits
+      for (size_t i = 0; i < std::min(Bins.size(), SweptBins.size()); i++)
+        BOOST_TEST(SweptContributors.at(SweptBins[i]) == Contributors.at(Bins[i]));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FillAccumulators_SameAsFillAccumulator)
+{
+  std::vector<double> const Times{7.6, 0.2, 3.4, 0.7, 7.9, 3.1, 5.5, 0.4, 7.2, 3.6, 9.9};
+  std::vector<double> const PEs{20, 30, 10, 25, 15, 20, 60, 10, 25, 30, 55};
+
+  std::vector<recob::OpHit> HitVector;
+  for (size_t i = 0; i < Times.size(); i++)
+    HitVector.emplace_back(0, Times[i], 0, 0, 0, 0, 0, PEs[i], 0);
+
+  double const MinTime = 0.2;
+  double const BinWidth = 1;
+
+  // The workspace is filled twice, as it would be by two events
+  opdet::OpFlashWorkspace Workspace;
+  opdet::FillAccumulators(HitVector, BinWidth, FlashThreshold, true, Workspace);
+  opdet::FillAccumulators(HitVector, BinWidth, FlashThreshold, false, Workspace);
+
+  for (int Accumulator = 1; Accumulator <= 2; Accumulator++) {
+    double const BinOffset = (Accumulator - 1) * BinWidth / 2.0;
+
+    std::vector<double> Binned(20);
+    std::vector<std::vector<int>> Contributors(20);
+    std::vector<int> FlashesInAccumulator;
+    for (size_t i = 0; i < HitVector.size(); i++)
+      opdet::FillAccumulator(opdet::GetAccumIndex(Times[i], MinTime, BinWidth, BinOffset),
+                             i,
+                             PEs[i],
+                             FlashThreshold,
+                             Binned,
+                             Contributors,
+                             FlashesInAccumulator);
+
+    opdet::FlashAccumulator const& Filled =
+      (Accumulator == 1) ? Workspace.Accumulator1 : Workspace.Accumulator2;
+
+    BOOST_TEST(Filled.FlashesInAccumulator == FlashesInAccumulator);
+    BOOST_TEST(Filled.Contributors.NLists() == Filled.Binned.size());
+    for (size_t Bin = 0; Bin < Filled.Binned.size(); Bin++) {
+      BOOST_TEST(Filled.Binned[Bin] == Binned.at(Bin));
+      BOOST_TEST(std::vector<int>(Filled.Contributors.Begin(Bin), Filled.Contributors.End(Bin)) ==
+                 Contributors.at(Bin));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(AssignHitsToFlash_EqualSizesAccumulator1First)
+{
+  // Hit 1 is in the flash bins of both accumulators, which have the same size
+  std::vector<double> const PEs{50, 20, 50};
+  std::vector<recob::OpHit> HitVector;
+  for (size_t i = 0; i < PEs.size(); i++)
+    HitVector.emplace_back(0, 0, 0, 0, 0, 0, 0, PEs[i], 0);
+
+  std::vector<int> const FlashesInAccumulator1{1};
+  std::vector<int> const FlashesInAccumulator2{0};
+  std::vector<double> const Binned1{0, 70};
+  std::vector<double> const Binned2{70, 0};
+  std::vector<std::vector<int>> const Contributors1{{}, {0, 1}};
+  std::vector<std::vector<int>> const Contributors2{{1, 2}, {}};
+
+  std::vector<std::vector<int>> HitsPerFlash;
+  opdet::AssignHitsToFlash(FlashesInAccumulator1,
+                           FlashesInAccumulator2,
+                           Binned1,
+                           Binned2,
+                           Contributors1,
+                           Contributors2,
+                           HitVector,
+                           HitsPerFlash,
+                           FlashThreshold);
+
+  BOOST_TEST(HitsPerFlash.size() == 2U);
+  BOOST_TEST((HitsPerFlash.at(0) == std::vector<int>{0, 1}));
+  BOOST_TEST((HitsPerFlash.at(1) == std::vector<int>{2}));
+}
+
 BOOST_AUTO_TEST_CASE(FillHitsThisFlash_EmptyContributors)
 {
 
@@ -705,6 +851,80 @@ BOOST_AUTO_TEST_CASE(AddHitToFlash_OutsideWidth)
   BOOST_TEST(FlashMinTime == 3.95);
 }
 
+BOOST_AUTO_TEST_CASE(RefineHitsInFlash_EqualPESeedInListOrder)
+{
+  // Three hits of the same PE: hit 1, first in the list, seeds a flash
+  // alone and is dropped; hit 0 then seeds the flash collecting hit 2
+  std::vector<recob::OpHit> HitVector;
+  HitVector.emplace_back(0, 0, 0, 0, 1, 0, 0, 30, 0);
+  HitVector.emplace_back(0, 100, 0, 0, 1, 0, 0, 30, 0);
+  HitVector.emplace_back(0, 0.25, 0, 0, 1, 0, 0, 30, 0);
+  std::vector<int> HitsThisFlash{1, 0, 2};
+
+  std::vector<std::vector<int>> RefinedHitsPerFlash;
+  opdet::RefineHitsInFlash(
+    HitsThisFlash, HitVector, RefinedHitsPerFlash, WidthTolerance, FlashThreshold);
+
+  BOOST_TEST(RefinedHitsPerFlash.size() == 1U);
+  BOOST_TEST(RefinedHitsPerFlash.at(0) == (std::vector<int>{0, 2}));
+}
+
+BOOST_AUTO_TEST_CASE(RefineHitsInFlash_GrowsOverSeveralPasses)
+{
+  // Hit 2 widens the flash enough to reach hit 1 at the next pass,
+  // and hit 1 in turn to reach hit 3 at the pass after
+  std::vector<recob::OpHit> HitVector;
+  HitVector.emplace_back(0, 0, 0, 0, 2, 0, 0, 100, 0);
+  HitVector.emplace_back(0, 2.75, 0, 0, 4, 0, 0, 40, 0);
+  HitVector.emplace_back(0, 1, 0, 0, 4, 0, 0, 20, 0);
+  HitVector.emplace_back(0, 4, 0, 0, 4, 0, 0, 60, 0);
+  std::vector<int> HitsThisFlash{0, 1, 2, 3};
+
+  std::vector<std::vector<int>> RefinedHitsPerFlash;
+  opdet::RefineHitsInFlash(
+    HitsThisFlash, HitVector, RefinedHitsPerFlash, WidthTolerance, FlashThreshold);
+
+  BOOST_TEST(RefinedHitsPerFlash.size() == 1U);
+  BOOST_TEST(RefinedHitsPerFlash.at(0) == (std::vector<int>{0, 2, 1, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(RefineHitsInFlash_ReleasedHitJoinsNextFlash)
+{
+  // Hit 2 seeds a flash with hit 1 which stays below threshold: hit 1 is
+  // released, and completes the flash seeded by hit 0 with hit 3
+  std::vector<recob::OpHit> HitVector;
+  HitVector.emplace_back(0, 0, 0, 0, 2, 0, 0, 25, 0);
+  HitVector.emplace_back(0, 0.875, 0, 0, 2, 0, 0, 15, 0);
+  HitVector.emplace_back(0, 1.75, 0, 0, 2, 0, 0, 28, 0);
+  HitVector.emplace_back(0, -0.5, 0, 0, 2, 0, 0, 12, 0);
+  std::vector<int> HitsThisFlash{0, 1, 2, 3};
+
+  std::vector<std::vector<int>> RefinedHitsPerFlash;
+  opdet::RefineHitsInFlash(
+    HitsThisFlash, HitVector, RefinedHitsPerFlash, WidthTolerance, FlashThreshold);
+
+  BOOST_TEST(RefinedHitsPerFlash.size() == 1U);
+  BOOST_TEST(RefinedHitsPerFlash.at(0) == (std::vector<int>{0, 1, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(RefineHitsInFlash_HitOnToleranceBoundary)
+{
+  // Hit 1 is exactly WidthTolerance * (hit + flash half widths) away from
+  // the flash centre, and joins it; hit 2 is just beyond, and does not
+  std::vector<recob::OpHit> HitVector;
+  HitVector.emplace_back(0, 0, 0, 0, 2, 0, 0, 60, 0);
+  HitVector.emplace_back(0, 1, 0, 0, 2, 0, 0, 10, 0);
+  HitVector.emplace_back(0, -1 - 1. / 1024, 0, 0, 2, 0, 0, 20, 0);
+  std::vector<int> HitsThisFlash{0, 1, 2};
+
+  std::vector<std::vector<int>> RefinedHitsPerFlash;
+  opdet::RefineHitsInFlash(
+    HitsThisFlash, HitVector, RefinedHitsPerFlash, WidthTolerance, FlashThreshold);
+
+  BOOST_TEST(RefinedHitsPerFlash.size() == 1U);
+  BOOST_TEST(RefinedHitsPerFlash.at(0) == (std::vector<int>{0, 1}));
+}
+
 BOOST_AUTO_TEST_CASE(CheckAndStoreFlash_AboveThreshold)
 {
   std::vector<std::vector<int>> RefinedHitsPerFlash;
@@ -1084,6 +1304,124 @@ BOOST_AUTO_TEST_CASE(MarkFlashesForRemoval_RemoveOneFlash)
   BOOST_TEST(FlashVector[2].TotalPE() == 100);
 }
 
+BOOST_AUTO_TEST_CASE(MarkFlashesForRemoval_RemoveLateWideFlash)
+{
+  size_t NFlashes = 3;
+  size_t BeginFlash = 0;
+
+  std::vector<double> PEs(30, 0);
+  PEs.at(0) = 100;
+  std::vector<double> PEs_Small(30, 0);
+  PEs_Small.at(0) = 5;
+  std::vector<double> WireCenters(3, 0);
+  std::vector<double> WireWidths(3, 0);
+
+  // The late light of a narrow flash is still there many time constants
+  // later for a much wider flash
+  std::vector<recob::OpFlash> FlashVector;
+  FlashVector.emplace_back(0,    //time
+                           0.01, //TimeWidth,
+                           0,    //AveAbsTime,
+                           0,    //Frame,
+                           PEs,
+                           0, //InBeamFrame,
+                           0, //OnBeamTime,
+                           0, //FastToTotal,
+                           0, //meany,
+                           0, //widthy,
+                           0, //meanz,
+                           0, //widthz,
+                           WireCenters,
+                           WireWidths);
+  FlashVector.emplace_back(20,  //time
+                           100, //TimeWidth,
+                           0,   //AveAbsTime,
+                           0,   //Frame,
+                           PEs_Small,
+                           0, //InBeamFrame,
+                           0, //OnBeamTime,
+                           0, //FastToTotal,
+                           0, //meany,
+                           0, //widthy,
+                           0, //meanz,
+                           0, //widthz,
+                           WireCenters,
+                           WireWidths);
+  FlashVector.emplace_back(21,  //time
+                           0.5, //TimeWidth,
+                           0,   //AveAbsTime,
+                           0,   //Frame,
+                           PEs,
+                           0, //InBeamFrame,
+                           0, //OnBeamTime,
+                           0, //FastToTotal,
+                           0, //meany,
+                           0, //widthy,
+                           0, //meanz,
+                           0, //widthz,
+                           WireCenters,
+                           WireWidths);
+  std::vector<bool> MarkedForRemoval(NFlashes - BeginFlash, false);
+
+  opdet::MarkFlashesForRemoval(FlashVector, BeginFlash, MarkedForRemoval);
+
+  BOOST_TEST(MarkedForRemoval.size() == 3U);
+  BOOST_TEST(MarkedForRemoval[0] == false);
+  BOOST_TEST(MarkedForRemoval[1] == true);
+  BOOST_TEST(MarkedForRemoval[2] == false);
+}
+
+BOOST_AUTO_TEST_CASE(MarkFlashesForRemoval_ZeroWidthFlashMarksNothing)
+{
+  size_t NFlashes = 2;
+  size_t BeginFlash = 0;
+
+  std::vector<double> PEs(30, 0);
+  PEs.at(0) = 100;
+  std::vector<double> PEs_Small(30, 0);
+  PEs_Small.at(0) = 5;
+  std::vector<double> WireCenters(3, 0);
+  std::vector<double> WireWidths(3, 0);
+
+  // A single-hit flash has no width, and its late light cannot be estimated
+  std::vector<recob::OpFlash> FlashVector;
+  FlashVector.emplace_back(0, //time
+                           0, //TimeWidth,
+                           0, //AveAbsTime,
+                           0, //Frame,
+                           PEs,
+                           0, //InBeamFrame,
+                           0, //OnBeamTime,
+                           0, //FastToTotal,
+                           0, //meany,
+                           0, //widthy,
+                           0, //meanz,
+                           0, //widthz,
+                           WireCenters,
+                           WireWidths);
+  FlashVector.emplace_back(1.6, //time
+                           0.5, //TimeWidth,
+                           0,   //AveAbsTime,
+                           0,   //Frame,
+                           PEs_Small,
+                           0, //InBeamFrame,
+                           0, //OnBeamTime,
+                           0, //FastToTotal,
+                           0, //meany,
+                           0, //widthy,
+                           0, //meanz,
+                           0, //widthz,
+                           WireCenters,
+                           WireWidths);
+  std::vector<bool> MarkedForRemoval(NFlashes - BeginFlash, false);
+
+  opdet::MarkFlashesForRemoval(FlashVector, BeginFlash, MarkedForRemoval);
+
+  BOOST_TEST(MarkedForRemoval.size() == 2U);
+  BOOST_TEST(MarkedForRemoval[0] == false);
+  BOOST_TEST(MarkedForRemoval[1] == false);
+}
+
 BOOST_AUTO_TEST_CASE(MarkFlashesForRemoval_IgnoreFirstFlash)
 {
   size_t NFlashes = 4;
@@ -1276,4 +1614,130 @@ BOOST_AUTO_TEST_CASE(RemoveFlashesFromVectors_NoFlashes)
   BOOST_TEST(FlashVector.size() == NFlashes);
 }
 
+BOOST_AUTO_TEST_CASE(RemoveLateLight_SortsHitsWithFlashes)
+{
+  // One flash already stored, then three new, well separated flashes out of time order
+  std::vector<recob::OpFlash> FlashVector;
+  FlashVector.emplace_back(-500, 1, -500, 1, std::vector<double>{10});
+  FlashVector.emplace_back(300, 1, 300, 1, std::vector<double>{10});
+  FlashVector.emplace_back(-100, 1, -100, 1, std::vector<double>{10});
+  FlashVector.emplace_back(100, 1, 100, 1, std::vector<double>{10});
+
+  std::vector<std::vector<int>> RefinedHitsPerFlash{{3}, {1, 2}, {4, 5, 6}};
+
+  opdet::RemoveLateLight(FlashVector, RefinedHitsPerFlash);
+
+  BOOST_TEST(FlashVector.size() == 4U);
+  BOOST_TEST(RefinedHitsPerFlash.size() == 3U);
+  BOOST_TEST(FlashVector[0].Time() == -500);
+  BOOST_TEST(FlashVector[1].Time() == -100);
+  BOOST_TEST(FlashVector[2].Time() == 100);
+  BOOST_TEST(FlashVector[3].Time() == 300);
+  BOOST_TEST((RefinedHitsPerFlash[0] == std::vector<int>{1, 2}));
+  BOOST_TEST((RefinedHitsPerFlash[1] == std::vector<int>{4, 5, 6}));
+  BOOST_TEST((RefinedHitsPerFlash[2] == std::vector<int>{3}));
+}
+
+// Four detectors, channels 0 and 1 in partition 0 and channels 2 and 3 in partition 1
+opdet::OpChannelGeometry const PartitionGeometry(1, {0, 0, 0, 0}, {0, 10, 20, 30});
+std::vector<unsigned int> const ChannelPartition{0, 0, 1, 1};
+
+detinfo::DetectorClocksData MakeClocksData()
+{
+  detinfo::ElecClock const clock(0, 1600, 64);
+  return detinfo::DetectorClocksData(0, 0, 0, 0, clock, clock, clock, clock);
+}
+
+BOOST_AUTO_TEST_CASE(RunFlashFinder_PartitionsAreIndependent)
+{
+  // The hits at 1 us would make one flash together, but the partition 0 hit
+  // alone is below threshold; the flashes come in partition order, not time
+  std::vector<recob::OpHit> HitVector;
+  HitVector.emplace_back(2, 1, 1, 0, 1, 0, 0, 60, 0);
+  HitVector.emplace_back(0, 5, 5, 0, 1, 0, 0, 60, 0);
+  HitVector.emplace_back(3, 1, 1, 0, 1, 0, 0, 30, 0);
+  HitVector.emplace_back(1, 1, 1, 0, 1, 0, 0, 30, 0);
+
+  std::vector<recob::OpFlash> FlashVector;
+  std::vector<std::vector<int>> AssocList;
+  std::vector<opdet::OpFlashWorkspace> Workspaces(2);
+  for (bool const SweepSeeding : {false, true}) {
+    FlashVector.clear();
+    AssocList.clear();
+    opdet::RunFlashFinder(HitVector,
+                          FlashVector,
+                          AssocList,
+                          1,
+                          PartitionGeometry,
+                          FlashThreshold,
+                          WidthTolerance,
+                          MakeClocksData(),
+                          2.5,
+                          SweepSeeding,
+                          ChannelPartition,
+                          Workspaces);
+
+    BOOST_TEST(FlashVector.size() == 2U);
+    BOOST_TEST(AssocList.size() == 2U);
+    BOOST_TEST(FlashVector[0].Time() == 5, tolerance);
+    BOOST_TEST(FlashVector[0].TotalPE() == 60, tolerance);
+    BOOST_TEST(FlashVector[1].Time() == 1, tolerance);
+    BOOST_TEST(FlashVector[1].TotalPE() == 90, tolerance);
+    BOOST_TEST((AssocList[0] == std::vector<int>{1}));
+    BOOST_TEST((AssocList[1] == std::vector<int>{0, 2}));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RunFlashFinder_PartitionAppendsToFlashes)
+{
+  // An empty partition adds nothing, and earlier flashes are kept
+  std::vector<recob::OpHit> HitVector;
+  HitVector.emplace_back(3, 1, 1, 0, 1, 0, 0, 60, 0);
+
+  std::vector<recob::OpFlash> FlashVector;
+  FlashVector.emplace_back(-500, 1, -500, 1, std::vector<double>{10});
+  std::vector<std::vector<int>> AssocList{{7}};
+  std::vector<opdet::OpFlashWorkspace> Workspaces(2);
+  opdet::RunFlashFinder(HitVector,
+                        FlashVector,
+                        AssocList,
+                        1,
+                        PartitionGeometry,
+                        FlashThreshold,
+                        WidthTolerance,
+                        MakeClocksData(),
+                        2.5,
+                        false,
+                        ChannelPartition,
+                        Workspaces);
+
+  BOOST_TEST(FlashVector.size() == 2U);
+  BOOST_TEST(FlashVector[0].Time() == -500);
+  BOOST_TEST(FlashVector[1].Time() == 1, tolerance);
+  BOOST_TEST((AssocList == std::vector<std::vector<int>>{{7}, {0}}));
+}
+
+BOOST_AUTO_TEST_CASE(RunFlashFinder_ChannelWithoutPartition)
+{
+  std::vector<recob::OpHit> HitVector;
+  HitVector.emplace_back(4, 1, 1, 0, 1, 0, 0, 60, 0);
+
+  std::vector<recob::OpFlash> FlashVector;
+  std::vector<std::vector<int>> AssocList;
+  std::vector<opdet::OpFlashWorkspace> Workspaces(2);
+  BOOST_CHECK_THROW(opdet::RunFlashFinder(HitVector,
+                                          FlashVector,
+                                          AssocList,
+                                          1,
+                                          PartitionGeometry,
+                                          FlashThreshold,
+                                          WidthTolerance,
+                                          MakeClocksData(),
+                                          2.5,
+                                          false,
+                                          ChannelPartition,
+                                          Workspaces),
+                    cet::exception);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
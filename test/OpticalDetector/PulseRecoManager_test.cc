@@ -0,0 +1,199 @@
+#define BOOST_TEST_MODULE (PulseRecoManager_test)
+#include "boost/test/unit_test.hpp"
+
+#include "larana/OpticalDetector/OpHitFinder/AlgoCFD.h"
+#include "larana/OpticalDetector/OpHitFinder/AlgoFixedWindow.h"
+#include "larana/OpticalDetector/OpHitFinder/AlgoSlidingWindow.h"
+#include "larana/OpticalDetector/OpHitFinder/AlgoThreshold.h"
+#include "larana/OpticalDetector/OpHitFinder/OpticalRecoException.h"
+#include "larana/OpticalDetector/OpHitFinder/PedAlgoEdges.h"
+#include "larana/OpticalDetector/OpHitFinder/PulseRecoManager.h"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <cmath>  // std::exp
+#include <random> // std::mt19937
+
+constexpr size_t ChunkSize = 1000;
+constexpr size_t ChunkOverlap = 100;
+
+// The CFD crossing is interpolated in chunk ticks before the chunk start is added
+auto const tolerance = 1e-12 % boost::test_tools::tolerance();
+
+fhicl::ParameterSet ThresholdPset()
+{
+  fhicl::ParameterSet pset;
+  pset.put("StartADCThreshold", 5.0);
+  pset.put("EndADCThreshold", 2.0);
+  pset.put("NSigmaThresholdStart", 5.0);
+  pset.put("NSigmaThresholdEnd", 3.0);
+  return pset;
+}
+
+fhicl::ParameterSet SlidingWindowPset()
+{
+  fhicl::ParameterSet pset;
+  pset.put("NumPreSample", 3);
+  pset.put("ADCThreshold", 4.0);
+  pset.put("NSigmaThreshold", 4.0);
+  pset.put("EndADCThreshold", 2.0);
+  pset.put("EndNSigmaThreshold", 1.0);
+  pset.put("Verbosity", false);
+  return pset;
+}
+
+fhicl::ParameterSet CFDPset()
+{
+  fhicl::ParameterSet pset;
+  pset.put("Fraction", 0.9);
+  pset.put("Delay", 2);
+  pset.put("PeakThresh", 7.5);
+  pset.put("StartThresh", 5.0);
+  pset.put("EndThresh", 1.5);
+  return pset;
+}
+
+fhicl::ParameterSet EdgesPset(int method)
+{
+  fhicl::ParameterSet pset;
+  pset.put("NumSampleFront", 3);
+  pset.put("NumSampleTail", 3);
+  pset.put("Method", method);
+  return pset;
+}
+
+// Noisy baseline with pulses across every chunk boundary, across the first sample
+// of every chunk with its overlap, and in the short remainder merged into the last chunk
+pmtana::Waveform_t ChunkedWaveform()
+{
+  size_t const nsamples = 10 * ChunkSize + ChunkSize / 2;
+  std::vector<double> adc(nsamples, 2000);
+
+  auto const addPulse = [&adc](size_t start, double amplitude) {
+    for (size_t i = start; i < std::min(adc.size(), start + 60); ++i)
+      adc[i] += amplitude * std::exp(-(i - start) / 8.0);
+  };
+  for (size_t boundary = ChunkSize; boundary < nsamples; boundary += ChunkSize) {
+    addPulse(boundary - 10, 80);
+    addPulse(boundary - ChunkOverlap - 5, 40);
+  }
+  addPulse(nsamples - 200, 60);
+
+  std::mt19937 engine(7);
+  std::normal_distribution<double> noise(0, 1);
+  pmtana::Waveform_t wf(nsamples);
+  for (size_t i = 0; i < nsamples; ++i)
+    wf[i] = static_cast<short>(std::lround(adc[i] + noise(engine)));
+  return wf;
+}
+
+void CheckSamePulses(pmtana::pulse_param_array const& chunked,
+                     pmtana::pulse_param_array const& whole)
+{
+  BOOST_TEST(chunked.size() == whole.size());
+  for (size_t i = 0; i < std::min(chunked.size(), whole.size()); ++i) {
+    BOOST_TEST_CONTEXT("pulse " << i)
+    {
+      BOOST_TEST(chunked[i].t_start == whole[i].t_start);
+      BOOST_TEST(chunked[i].t_max == whole[i].t_max);
+      BOOST_TEST(chunked[i].t_end == whole[i].t_end);
+      BOOST_TEST(chunked[i].t_cfdcross == whole[i].t_cfdcross, tolerance);
+      BOOST_TEST(chunked[i].peak == whole[i].peak);
+      BOOST_TEST(chunked[i].area == whole[i].area);
+      BOOST_TEST(chunked[i].ped_mean == whole[i].ped_mean);
+      BOOST_TEST(chunked[i].ped_sigma == whole[i].ped_sigma);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(PulseRecoManager_test)
+
+BOOST_AUTO_TEST_CASE(Chunking_SamePulsesAsWholeWaveform)
+{
+  auto const wf = ChunkedWaveform();
+
+  // The same algorithms, on the whole waveform and in chunks
+  pmtana::AlgoThreshold threshold(ThresholdPset(), nullptr);
+  pmtana::AlgoSlidingWindow sliding(SlidingWindowPset(), nullptr);
+  pmtana::AlgoCFD cfd(CFDPset(), nullptr);
+  pmtana::PedAlgoEdges ped(EdgesPset(pmtana::PedAlgoEdges::kHEAD));
+  pmtana::PedAlgoEdges cfdPed(EdgesPset(pmtana::PedAlgoEdges::kBOTH));
+
+  pmtana::AlgoThreshold chunkedThreshold(ThresholdPset(), nullptr);
+  pmtana::AlgoSlidingWindow chunkedSliding(SlidingWindowPset(), nullptr);
+  pmtana::AlgoCFD chunkedCfd(CFDPset(), nullptr);
+  pmtana::PedAlgoEdges chunkedPed(EdgesPset(pmtana::PedAlgoEdges::kHEAD));
+  pmtana::PedAlgoEdges chunkedCfdPed(EdgesPset(pmtana::PedAlgoEdges::kBOTH));
+
+  pmtana::PulseRecoManager whole;
+  whole.AddRecoAlgo(&threshold);
+  whole.AddRecoAlgo(&sliding);
+  whole.AddRecoAlgo(&cfd, &cfdPed);
+  whole.SetDefaultPedAlgo(&ped);
+
+  pmtana::PulseRecoManager chunked;
+  chunked.AddRecoAlgo(&chunkedThreshold);
+  chunked.AddRecoAlgo(&chunkedSliding);
+  chunked.AddRecoAlgo(&chunkedCfd, &chunkedCfdPed);
+  chunked.SetDefaultPedAlgo(&chunkedPed);
+  chunked.SetChunking(ChunkSize, ChunkOverlap);
+
+  BOOST_TEST(whole.Reconstruct(wf));
+  BOOST_TEST(chunked.Reconstruct(wf));
+
+  // At least the pulses across the chunk boundaries
+  BOOST_TEST(threshold.GetNPulse() >= 10U);
+  BOOST_TEST(sliding.GetNPulse() >= 10U);
+  BOOST_TEST(cfd.GetNPulse() >= 10U);
+
+  CheckSamePulses(chunkedThreshold.GetPulses(), threshold.GetPulses());
+  CheckSamePulses(chunkedSliding.GetPulses(), sliding.GetPulses());
+  CheckSamePulses(chunkedCfd.GetPulses(), cfd.GetPulses());
+  BOOST_TEST(chunkedPed.Mean() == ped.Mean());
+  BOOST_TEST(chunkedCfdPed.Sigma() == cfdPed.Sigma());
+}
+
+BOOST_AUTO_TEST_CASE(Chunking_ShortWaveformIsWhole)
+{
+  // Less than two chunks: the remainder is merged, so there is one chunk
+  auto wf = ChunkedWaveform();
+  wf.resize(2 * ChunkSize - 1);
+
+  pmtana::AlgoThreshold threshold(ThresholdPset(), nullptr);
+  pmtana::AlgoThreshold chunkedThreshold(ThresholdPset(), nullptr);
+  pmtana::PedAlgoEdges ped(EdgesPset(pmtana::PedAlgoEdges::kHEAD));
+
+  pmtana::PulseRecoManager whole;
+  whole.AddRecoAlgo(&threshold);
+  whole.SetDefaultPedAlgo(&ped);
+  BOOST_TEST(whole.Reconstruct(wf));
+
+  pmtana::PulseRecoManager chunked;
+  chunked.AddRecoAlgo(&chunkedThreshold);
+  chunked.SetDefaultPedAlgo(&ped);
+  chunked.SetChunking(ChunkSize, ChunkOverlap);
+  BOOST_TEST(chunked.Reconstruct(wf));
+
+  CheckSamePulses(chunkedThreshold.GetPulses(), threshold.GetPulses());
+}
+
+BOOST_AUTO_TEST_CASE(Chunking_NeedsOverlap)
+{
+  pmtana::PulseRecoManager manager;
+  BOOST_CHECK_THROW(manager.SetChunking(ChunkSize, 0), pmtana::OpticalRecoException);
+  BOOST_CHECK_NO_THROW(manager.SetChunking(0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(Chunking_NotWithFixedWindow)
+{
+  fhicl::ParameterSet pset;
+  pset.put("StartIndex", 0);
+  pset.put("EndIndex", 20);
+  pmtana::AlgoFixedWindow window(pset, nullptr);
+
+  pmtana::PulseRecoManager manager;
+  manager.SetChunking(ChunkSize, ChunkOverlap);
+  BOOST_CHECK_THROW(manager.AddRecoAlgo(&window), pmtana::OpticalRecoException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
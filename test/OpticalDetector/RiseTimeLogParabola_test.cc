@@ -0,0 +1,102 @@
+#define BOOST_TEST_MODULE (RiseTimeLogParabola_test)
+#include "boost/test/unit_test.hpp"
+
+#include "larana/OpticalDetector/OpHitFinder/RiseTimeTools/GaussPeak.h"
+
+#include "TF1.h"
+#include "TH1F.h"
+
+#include <cmath>  // std::exp
+#include <random> // std::mt19937
+
+// Gaussian pulse of the given amplitude, centre and width, sampled at each tick
+std::vector<double> GaussPulse(double amplitude, double centre, double sigma, size_t nsamples)
+{
+  std::vector<double> pulse(nsamples);
+  for (size_t i = 0; i < nsamples; ++i)
+    pulse[i] = amplitude * std::exp(-0.5 * std::pow((i - centre) / sigma, 2));
+  return pulse;
+}
+
+// Centre of the first maximum from a ROOT fit, as done by RiseTimeGaussFit
+double FitPeak(std::vector<double> const& pulse, size_t first_max, int nbins, double init_sigma)
+{
+  TH1F h_aux("aux", "aux", pulse.size(), -0.5, pulse.size() - 0.5);
+  h_aux.SetDirectory(nullptr);
+  for (size_t j = 0; j < pulse.size(); j++)
+    h_aux.SetBinContent(j + 1, pulse[j]);
+
+  TF1 f("f", "gaus", double(first_max) - nbins, double(first_max) + nbins, TF1::EAddToList::kNo);
+  f.SetParameters(pulse[first_max], first_max, init_sigma);
+  h_aux.Fit(&f, "qN", "", double(first_max) - nbins, double(first_max) + nbins);
+  return f.GetParameter(1);
+}
+
+BOOST_AUTO_TEST_SUITE(RiseTimeLogParabola_test)
+
+BOOST_AUTO_TEST_CASE(checkFindFirstMax)
+{
+
+  BOOST_TEST(pmtana::FindFirstMax({1, 5, 3, 8, 2}, 4) == 1ul);
+  BOOST_TEST(pmtana::FindFirstMax({1, 3, 2, 8, 2}, 4) == 3ul);
+  BOOST_TEST(pmtana::FindFirstMax({1, 3, 2, 3, 2}, 4) == 5ul);
+  BOOST_TEST(pmtana::FindFirstMax({}, 4) == 0ul);
+}
+
+BOOST_AUTO_TEST_CASE(checkNoiselessPulses)
+{
+
+  for (double centre : {10.0, 10.3, 10.5, 10.8}) {
+    for (double sigma : {1.5, 3.0, 6.0}) {
+      auto const pulse = GaussPulse(100, centre, sigma, 40);
+      size_t const first_max = pmtana::FindFirstMax(pulse, 4);
+
+      // the log of a Gaussian is a parabola: the closed form is exact
+      for (size_t half_width : {1ul, 2ul})
+        BOOST_TEST(pmtana::LogParabolaPeak(pulse, first_max, half_width) == centre,
+                   1e-6 % boost::test_tools::tolerance());
+
+      BOOST_TEST(pmtana::LogParabolaPeak(pulse, first_max, 2) ==
+                   FitPeak(pulse, first_max, 3, 8.0),
+                 1e-3 % boost::test_tools::tolerance());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(checkNoisyPulses)
+{
+
+  std::mt19937 engine(12345);
+  std::normal_distribution<double> noise(0, 1);
+
+  for (int i = 0; i < 100; ++i) {
+    double const centre = 10 + 0.01 * i;
+    auto pulse = GaussPulse(100, centre, 2.0, 40);
+    for (auto& sample : pulse)
+      sample += noise(engine);
+
+    size_t const first_max = pmtana::FindFirstMax(pulse, 4);
+    double const peak = pmtana::LogParabolaPeak(pulse, first_max, 2);
+
+    BOOST_TEST(std::abs(peak - FitPeak(pulse, first_max, 3, 8.0)) < 0.1);
+    BOOST_TEST(std::abs(peak - centre) < 0.1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(checkDegeneratePulses)
+{
+
+  // flat top: no parabola maximum, the sample of the maximum is kept
+  std::vector<double> const flat(9, 10.);
+  BOOST_TEST(pmtana::LogParabolaPeak(flat, 4, 2) == 4.);
+
+  // not enough positive samples
+  std::vector<double> const spike{0., 0., 0., 10., 0., 0., 0.};
+  BOOST_TEST(pmtana::LogParabolaPeak(spike, 3, 2) == 3.);
+
+  // maximum at the edge of the pulse
+  auto const edge = GaussPulse(100, 0.2, 2.0, 10);
+  BOOST_TEST(pmtana::LogParabolaPeak(edge, 0, 2) == 0.2, 1e-6 % boost::test_tools::tolerance());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
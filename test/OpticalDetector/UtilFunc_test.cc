@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE (UtilFunc_test)
+#include "boost/test/unit_test.hpp"
+
+#include "larana/OpticalDetector/OpHitFinder/OpticalRecoException.h"
+#include "larana/OpticalDetector/OpHitFinder/UtilFunc.h"
+
+#include <cmath>  // std::abs
+#include <limits> // std::numeric_limits
+#include <random> // std::mt19937
+
+// WindowStats must match the direct mean and std up to floating point rounding
+constexpr double relTolerance = 1e-9;
+
+// Window length up to which WindowStats::Sigma() is computed in integer arithmetic
+constexpr size_t exactSigmaSamples = size_t(1) << 16;
+
+std::vector<short> PedestalWaveform(size_t nsamples, unsigned int seed)
+{
+  std::mt19937 engine(seed);
+  std::normal_distribution<double> noise(2000, 2);
+  std::vector<short> wf(nsamples);
+  for (auto& sample : wf)
+    sample = static_cast<short>(std::lround(noise(engine)));
+  return wf;
+}
+
+std::vector<short> FullRangeWaveform(size_t nsamples, unsigned int seed)
+{
+  std::mt19937 engine(seed);
+  std::uniform_int_distribution<int> adc(std::numeric_limits<short>::min(),
+                                         std::numeric_limits<short>::max());
+  std::vector<short> wf(nsamples);
+  for (auto& sample : wf)
+    sample = static_cast<short>(adc(engine));
+  return wf;
+}
+
+void CheckWindow(pmtana::WindowStats const& stats,
+                 std::vector<short> const& wf,
+                 size_t start,
+                 size_t nsample)
+{
+  BOOST_TEST_CONTEXT("window " << start << " + " << nsample)
+  {
+    double const mean = pmtana::mean(wf, start, nsample);
+    double const sigma = pmtana::std(wf, mean, start, nsample);
+    BOOST_TEST(std::abs(stats.Mean(start, nsample) - mean) <=
+               relTolerance * std::max(1.0, std::abs(mean)));
+    BOOST_TEST(std::abs(stats.Sigma(start, nsample) - sigma) <=
+               relTolerance * std::max(1.0, sigma));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(UtilFunc_test)
+
+BOOST_AUTO_TEST_CASE(WindowStats_RandomWindows)
+{
+  std::mt19937 engine(11);
+  pmtana::WindowStats stats;
+  for (unsigned int seed = 0; seed < 4; ++seed) {
+    for (auto const& wf : {PedestalWaveform(5000, seed), FullRangeWaveform(5000, seed)}) {
+      stats.Fill(wf);
+      BOOST_TEST(stats.Size() == wf.size());
+
+      std::uniform_int_distribution<size_t> start(0, wf.size() - 1);
+      for (int i = 0; i < 200; ++i) {
+        size_t const first = start(engine);
+        size_t const nsample = std::uniform_int_distribution<size_t>(1, wf.size() - first)(engine);
+        CheckWindow(stats, wf, first, nsample);
+      }
+      // short windows, as used by the pedestal algorithms
+      for (size_t nsample : {1, 2, 3, 7, 14})
+        CheckWindow(stats, wf, start(engine) % (wf.size() - nsample), nsample);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WindowStats_WholeWaveform)
+{
+  auto const wf = PedestalWaveform(1000, 3);
+  pmtana::WindowStats stats;
+  stats.Fill(wf);
+
+  // nsample 0 means the whole waveform, as for pmtana::mean and pmtana::std
+  double const mean = pmtana::mean(wf);
+  BOOST_TEST(std::abs(stats.Mean() - mean) <= relTolerance * mean);
+  BOOST_TEST(std::abs(stats.Sigma() - pmtana::std(wf, mean)) <= relTolerance);
+  BOOST_CHECK_THROW(pmtana::mean(wf, 400), pmtana::OpticalRecoException);
+  BOOST_CHECK_THROW(stats.Mean(400), pmtana::OpticalRecoException);
+}
+
+BOOST_AUTO_TEST_CASE(WindowStats_ExactAndFloatSigma)
+{
+  // Windows on both sides of the switch from integer to floating point variance
+  pmtana::WindowStats stats;
+  for (auto const& wf : {PedestalWaveform(exactSigmaSamples + 10, 5),
+                         FullRangeWaveform(exactSigmaSamples + 10, 5)}) {
+    stats.Fill(wf);
+    for (size_t nsample : {exactSigmaSamples - 1, exactSigmaSamples, exactSigmaSamples + 1})
+      for (size_t start : {size_t(0), size_t(9) + exactSigmaSamples - nsample})
+        CheckWindow(stats, wf, start, nsample);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WindowStats_FlatWindowHasNoSigma)
+{
+  // A flat window has exactly zero deviation in the integer branch, and never a
+  // negative variance (and NaN deviation) in the floating point one
+  std::vector<short> wf(exactSigmaSamples + 2, 2047);
+  pmtana::WindowStats stats;
+  stats.Fill(wf);
+  BOOST_TEST(stats.Sigma(0, 7) == 0.);
+  BOOST_TEST(stats.Sigma(0, exactSigmaSamples) == 0.);
+  BOOST_TEST(stats.Sigma(0, exactSigmaSamples + 1) >= 0.);
+  BOOST_TEST(stats.Sigma(0, exactSigmaSamples + 1) <= relTolerance);
+  BOOST_TEST(stats.Mean(1, exactSigmaSamples + 1) == 2047.);
+}
+
+BOOST_AUTO_TEST_CASE(WindowStats_InvalidWindow)
+{
+  auto const wf = PedestalWaveform(100, 1);
+  pmtana::WindowStats stats;
+  stats.Fill(wf);
+  BOOST_CHECK_THROW(stats.Mean(90, 11), pmtana::OpticalRecoException);
+  BOOST_CHECK_THROW(stats.Sigma(101, 1), pmtana::OpticalRecoException);
+  BOOST_CHECK_NO_THROW(stats.Sigma(90, 10));
+}
+
+BOOST_AUTO_TEST_SUITE_END()